@@ -0,0 +1,89 @@
+#ifndef CHANNELRESULTSTATE_H
+#define CHANNELRESULTSTATE_H
+
+#include <QtGlobal>
+#include <QVarLengthArray>
+
+/**
+ * @brief 单个通道的遥测判定状态 (位图)
+ * * 每条规则占一位：received / pass / ng 三组位图随采样增量更新。
+ * * "全部收齐且没有 NG" 只需要按字比较 required 位图，不再逐个读表格文字。
+ * * 128 条规则以内全部在栈上 (QVarLengthArray)，不分配堆内存。
+ *
+ * 只在通道工作线程中使用。
+ */
+class ChannelResultState
+{
+public:
+    // requiredMask: 参与判定的规则 (非 Display) 置 1
+    void reset(int ruleCount, const QVarLengthArray<quint64, 2> &requiredMask)
+    {
+        int words = (ruleCount + 63) / 64;
+        m_ruleCount = ruleCount;
+        m_required = requiredMask;
+        m_required.resize(words);
+        zero(m_received, words);
+        zero(m_pass, words);
+        zero(m_ng, words);
+    }
+
+    int ruleCount() const { return m_ruleCount; }
+
+    bool isReceived(int i) const { return test(m_received, i); }
+    bool isPass(int i) const { return test(m_pass, i); }
+    bool isNg(int i) const { return test(m_ng, i); }
+
+    // 合格：置 pass，清 ng
+    void markPass(int i) { set(m_received, i); set(m_pass, i); clear(m_ng, i); }
+    // 不合格：置 ng
+    void markNg(int i) { set(m_received, i); clear(m_pass, i); set(m_ng, i); }
+    // Display 项：只记录已收到
+    void markReceived(int i) { set(m_received, i); }
+
+    bool allReceived() const
+    {
+        for (int w = 0; w < m_required.size(); ++w) {
+            if ((m_received[w] & m_required[w]) != m_required[w]) return false;
+        }
+        return true;
+    }
+
+    bool anyNg() const
+    {
+        for (int w = 0; w < m_required.size(); ++w) {
+            if (m_ng[w] & m_required[w]) return true;
+        }
+        return false;
+    }
+
+    // mask 中的规则是否有 NG (用于提前判 NG 的规则子集)
+    bool anyNgIn(const QVarLengthArray<quint64, 2> &mask) const
+    {
+        int words = qMin(mask.size(), m_ng.size());
+        for (int w = 0; w < words; ++w) {
+            if (m_ng[w] & mask[w]) return true;
+        }
+        return false;
+    }
+
+private:
+    typedef QVarLengthArray<quint64, 2> Bits;
+
+    static void zero(Bits &b, int words)
+    {
+        b.resize(words);
+        for (int w = 0; w < words; ++w) b[w] = 0;
+    }
+    static bool test(const Bits &b, int i) { return (b[i >> 6] >> (i & 63)) & 1u; }
+    static void set(Bits &b, int i) { b[i >> 6] |= quint64(1) << (i & 63); }
+    static void clear(Bits &b, int i) { b[i >> 6] &= ~(quint64(1) << (i & 63)); }
+
+private:
+    int m_ruleCount = 0;
+    Bits m_required;
+    Bits m_received;
+    Bits m_pass;
+    Bits m_ng;
+};
+
+#endif // CHANNELRESULTSTATE_H
@@ -0,0 +1,950 @@
+#include "ChannelWorker.h"
+#include "SnManager.h"
+#include "IdentityLedger.h"
+#include "TelemetryTokenizer.h"
+#include "LogWriter.h"
+#include "SerialPortPool.h"
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cstring>
+
+ChannelWorker::ChannelWorker(int id, SnManager *snManager, QObject *parent)
+    : QObject(parent), m_id(id), m_snManager(snManager)
+{
+    // 串口与定时器都挂在 this 下，moveToThread 时会一起迁移到工作线程
+    m_serial = new QSerialPort(this);
+
+    m_testTimer = new QTimer(this);
+    m_testTimer->setSingleShot(true);
+    connect(m_testTimer, &QTimer::timeout, this, &ChannelWorker::onTestTimeout);
+
+    m_failFastTimer = new QTimer(this);
+    m_failFastTimer->setSingleShot(true);
+    connect(m_failFastTimer, &QTimer::timeout, this, &ChannelWorker::onFailFastTimeout);
+
+    m_noSignalTimer = new QTimer(this);
+    m_noSignalTimer->setSingleShot(true);
+    m_noSignalTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_noSignalTimer, &QTimer::timeout, this, &ChannelWorker::onNoSignalTimeout);
+
+    connect(m_serial, &QSerialPort::readyRead, this, &ChannelWorker::onSerialReadyRead);
+    connect(m_serial, &QSerialPort::errorOccurred, this, &ChannelWorker::onSerialError);
+
+    m_infoLog.reserve(4096);
+}
+
+// 析构函数 (在工作线程退出时执行)
+ChannelWorker::~ChannelWorker()
+{
+    closePort();
+    closeLogFile();
+}
+
+void ChannelWorker::applyConfig(const ChannelTestConfig &config)
+{
+    m_config = config;
+
+    const TelemetryRuleTable *table = m_config.telemetryTable.data();
+    int count = table ? table->size() : 0;
+    m_result.reset(count, table ? table->requiredMask() : QVarLengthArray<quint64, 2>());
+    m_itemValues.fill(QByteArray(), count);
+
+    // 提前判 NG 的遥测规则位图：单条规则的 fail_fast 优先，否则跟随 telemetry 类别
+    m_failFastMask.resize((count + 63) / 64);
+    for (int w = 0; w < m_failFastMask.size(); ++w) m_failFastMask[w] = 0;
+    if (m_config.failFast.enabled) {
+        for (int i = 0; i < count; ++i) {
+            const CompiledTelemetryRule &r = table->rule(i);
+            if (r.type == Type_Display) continue;
+            bool on = r.failFast < 0 ? m_config.failFast.onTelemetry : (r.failFast > 0);
+            if (on) m_failFastMask[i >> 6] |= quint64(1) << (i & 63);
+        }
+    }
+}
+
+void ChannelWorker::emitState()
+{
+    emit stateChanged(m_isTesting, m_hasError || m_duplicateIdentity, m_isImeiMismatch);
+}
+
+// ====================================================================
+// 1. 状态重置 (对应界面 resetUI)
+// ====================================================================
+void ChannelWorker::resetState(const ChannelTestConfig &config)
+{
+    // 0. 停止上一轮计时
+    if (m_testTimer->isActive()) {
+        m_testTimer->stop();
+    }
+    m_failFastTimer->stop();
+    m_noSignalTimer->stop();
+
+    // 1. 清空数据容器
+    m_expectedIds.clear();
+    m_currentIds.clear();
+    m_framer.clear();
+    applyConfig(config);
+
+    // 2. 重置状态
+    m_hasError = false;
+    m_isImeiMismatch = false;
+    m_duplicateIdentity = false;
+    m_isTesting = false;
+    m_failFastOnError = false;
+    m_gotFirstByte = false;
+    m_gotIdentity = false;
+    m_cycleClock.invalidate();
+    m_lastResetTime = QDateTime::currentMSecsSinceEpoch();
+    m_infoStatLines = 0;
+    m_infoStatNs = 0;
+    m_infoLog.resize(0);
+    m_infoLogBatches = 0;
+
+    emitState();
+}
+
+// ====================================================================
+// 2. 启动 / 停止
+// ====================================================================
+void ChannelWorker::startTest(const ChannelTestParams &params)
+{
+    applyConfig(params.config);
+
+    // 手动"开启"：非常驻模式下按旧逻辑先关闭串口；日志总是重新创建
+    if (params.reopenPort) {
+        if (!m_config.serialPersistent) closePort();
+        closeLogFile();
+    }
+
+    // 确保串口是打开的 (常驻模式下通常已经打开，这里几乎零开销)
+    bool wasOpen = m_serial->isOpen() && m_portName == params.portName;
+    QString error;
+    if (!ensurePortOpen(params.portName, params.baudRate, &error)) {
+        emitLog(error);
+        emitLog(">>> Error: 无法打开串口，测试无法启动!");
+        m_isTesting = false;
+        emitState();
+        return;
+    }
+    if (params.reopenPort && !wasOpen) emitLog("--- 端口已打开 ---");
+
+    // 新周期：清掉上一轮残留在驱动/缓冲区里的数据
+    beginCycle();
+
+    // 设置状态位 (落锁)
+    m_isTesting = true;
+
+    // 创建日志文件
+    createLogFile();
+
+    if (params.armTimer) {
+        emitLog(">>> 测试已启动 (监听串口数据...)");
+
+        // 启动超时倒计时
+        int timeoutMs = m_config.timeoutMs;
+        m_testTimer->start(timeoutMs);
+        emitLog(QString(">>> 超时倒计时已启动: %1 秒").arg(timeoutMs / 1000.0));
+
+        // 无信号期限与超时同时从启动沿开始计
+        m_gotFirstByte = false;
+        m_gotIdentity = false;
+        m_cycleClock.start();
+        scheduleNoSignalCheck();
+    }
+
+    emitState();
+}
+
+void ChannelWorker::stopTest()
+{
+    m_failFastTimer->stop();
+    m_noSignalTimer->stop();
+
+    // 手动停止：真正关闭串口并归还给串口池
+    if (m_serial->isOpen()) {
+        closePort();
+        m_isTesting = false;
+        emitLog("--- 端口已关闭 ---");
+
+        closeLogFile();
+
+        emit channelStatusChanged(true);
+        emitState();
+    }
+}
+
+void ChannelWorker::openPort(const QString &portName, int baudRate)
+{
+    if (portName.isEmpty()) return;
+
+    QString error;
+    if (!ensurePortOpen(portName, baudRate, &error)) emitLog(error);
+}
+
+bool ChannelWorker::ensurePortOpen(const QString &portName, int baudRate, QString *error)
+{
+    // 已经打开的就是这个口：只同步波特率 (不需要重新打开)
+    if (m_serial->isOpen() && m_portName == portName) {
+        if (m_serial->baudRate() != baudRate) m_serial->setBaudRate(baudRate);
+        return true;
+    }
+
+    // 换了串口：先把旧的归还
+    closePort();
+
+    SerialPortPool &pool = SerialPortPool::instance();
+    int owner = 0;
+    if (!pool.acquire(portName, m_id, &owner)) {
+        *error = QString(">>> Error: 串口 %1 已被通道 %2 占用").arg(portName).arg(owner);
+        return false;
+    }
+
+    m_serial->setPortName(portName);
+    m_serial->setBaudRate(baudRate);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_serial->open(QIODevice::ReadWrite)) {
+        pool.release(portName, m_id);
+        *error = QString(">>> Error: 打开串口 %1 失败 (%2)").arg(portName, m_serial->errorString());
+        return false;
+    }
+    qint64 costMs = timer.elapsed();
+
+    bool isReopen = (m_lastPortName == portName);
+    pool.recordOpen(portName, costMs, isReopen);
+    m_portName = portName;
+    m_lastPortName = portName;
+
+    SerialPortStats st = pool.stats(portName);
+    emitLog(QString(">>> 串口 %1 %2打开耗时 %3 ms (最大 %4 ms, 重开 %5 次)")
+                 .arg(portName, isReopen ? "重新" : "")
+                 .arg(costMs)
+                 .arg(st.maxOpenMs)
+                 .arg(st.reopenCount));
+    return true;
+}
+
+void ChannelWorker::closePort()
+{
+    if (m_serial->isOpen()) m_serial->close();
+    if (!m_portName.isEmpty()) {
+        SerialPortPool::instance().release(m_portName, m_id);
+        m_portName.clear();
+    }
+}
+
+void ChannelWorker::beginCycle()
+{
+    // 驱动缓冲和 QSerialPort 内部缓冲里都可能有上一轮的数据，全部丢掉
+    m_serial->clear(QSerialPort::Input);
+    qint64 stale = m_serial->readAll().size();
+    m_framer.clear();
+
+    ++m_generation;
+    if (stale > 0) {
+        emitLog(QString(">>> 周期 #%1: 丢弃上一轮残留数据 %2 字节").arg(m_generation).arg(stale));
+    }
+}
+
+void ChannelWorker::onSerialError(QSerialPort::SerialPortError error)
+{
+    // USB 转串口被拔出等：关闭并归还，下次启动时重新打开 (计入 reopen)
+    if (error != QSerialPort::ResourceError) return;
+
+    emitLog(QString(">>> Error: 串口 %1 异常断开 (%2)，下次启动时重新打开")
+                 .arg(m_portName, m_serial->errorString()));
+    closePort();
+}
+
+void ChannelWorker::setExpectedIdentity(const QString &key, const QString &value)
+{
+    // 转为大写 key 统一存储，防止大小写差异
+    // trimmed() 防止隐形空格
+    m_expectedIds.insert(key.toUpper(), value.trimmed());
+}
+
+void ChannelWorker::appendLogNote(const QString &text)
+{
+    QString note = QString("[%1] %2\n")
+                       .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"), text);
+    LogWriter::instance().write(m_logHandle, note.toLocal8Bit());
+}
+
+// ====================================================================
+// 3. 串口数据处理
+// ====================================================================
+void ChannelWorker::onSerialReadyRead()
+{
+    QLatin1String line;
+
+    // 串口数据直接读进环形缓冲区的空闲段，不再经过 readAll 的临时 QByteArray
+    while (true) {
+        int room = 0;
+        char *dst = m_framer.writeSpan(&room);
+        if (room <= 0) break;
+
+        qint64 n = m_serial->read(dst, room);
+        if (n <= 0) break;
+
+        if (!m_isTesting) {
+            // 非测试状态 (常驻串口的周期间隙) 直接丢弃，也不写入上一轮的日志
+            m_framer.clear();
+            continue;
+        }
+
+        // 写入文件：只拷贝进写入线程的缓冲，由它按时间/大小组提交
+        LogWriter::instance().write(m_logHandle, dst, n);
+
+        m_framer.commit(int(n));
+
+        if (!m_gotFirstByte) {
+            m_gotFirstByte = true;
+            scheduleNoSignalCheck();
+        }
+
+        quint64 overflowBefore = m_framer.overflowCount();
+        while (m_framer.nextLine(&line)) {
+            handleLine(line);
+        }
+        flushInfoLog();
+
+        // 超长行 (超过缓冲区容量仍无换行符) 被整行丢弃，记录下来而不是悄悄清空
+        if (m_framer.overflowCount() != overflowBefore) {
+            emitLog(QString(">>> Warning: 单行超过 %1 字节，已丢弃 (累计 %2 次, %3 字节)")
+                         .arg(m_framer.capacity())
+                         .arg(m_framer.overflowCount())
+                         .arg(m_framer.droppedBytes()));
+        }
+    }
+}
+
+void ChannelWorker::handleLine(QLatin1String raw)
+{
+    // $info 快速路径：直接在原始字节上切分和判定，整个过程不构造 QString
+    if (m_isTesting && m_config.telemetryFastPath) {
+        int pos = TelemetryTokenizer::indexOf(raw, "$info,");
+        if (pos >= 0) {
+            QElapsedTimer timer;
+            timer.start();
+            parseTelemetry(QLatin1String(raw.data() + pos + 6, raw.size() - pos - 6));
+            m_infoStatNs += timer.nsecsElapsed();
+            m_infoStatLines++;
+
+            // 界面日志只攒原始字节，本次读完再合并成一条发出 (见 flushInfoLog)
+            QLatin1String text = TelemetryTokenizer::trimmed(raw);
+            if (!m_infoLog.isEmpty()) m_infoLog.append('\n');
+            m_infoLog.append(text.data(), text.size());
+            return;
+        }
+    }
+
+    // 提取一行 (视图指向环形缓冲区，这里才转换成 QString)
+    QString line = QString::fromLocal8Bit(raw.data(), raw.size()).trimmed();
+
+    if(!line.isEmpty()) {
+        parseLine(line);
+        // 只有非空行才记录日志，避免日志里全是空行
+        emitLog(line);
+    }
+}
+
+// ====================================================================
+// 4. 核心解析逻辑
+// ====================================================================
+void ChannelWorker::parseLine(const QString &line)
+{
+    if(!m_isTesting) return;
+
+    // 预处理
+    QString cleanLine = line.trimmed();
+    if (cleanLine.isEmpty()) return;
+
+    // A. 遥测数据处理 ($info)，快速路径关闭时才会走到这里
+    if(cleanLine.contains("$info,")) {
+        int start = cleanLine.indexOf("$info,");
+        QElapsedTimer timer;
+        timer.start();
+        parseTelemetryLegacy(cleanLine.mid(start + 6));
+        m_infoStatNs += timer.nsecsElapsed();
+        m_infoStatLines++;
+        return;
+    }
+
+    // B. 获取规则 (使用启动时的配置快照)
+    const auto &idRules = m_config.identityRules;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    bool anyUpdate = false;
+    bool stateDirty = false;
+
+    // C. 遍历规则
+    for(const auto& rule : idRules) {
+        if(!rule.enable) continue;
+
+        if(cleanLine.startsWith(rule.prefix, Qt::CaseInsensitive)) {
+            QString key = rule.key.toUpper();
+
+            // 提取值
+            QString val = cleanLine.mid(rule.prefix.length()).trimmed();
+            if (val.startsWith(":")) val = val.mid(1).trimmed();
+            if(val.isEmpty()) continue;
+
+            // [1. 去重机制]
+            if (m_currentIds.value(key) == val) {
+                if (now - m_lastResetTime < 8000) continue;
+            }
+
+            qDebug() << ">>> [Serial Recv] Channel" << m_id << "Got:" << key << "=" << val;
+
+            // 立即更新数据和显示 (无论对错)
+            m_currentIds.insert(key, val);
+            updateSerialDisplay();
+            anyUpdate = true;
+
+            if (!m_gotIdentity) {
+                m_gotIdentity = true;
+                scheduleNoSignalCheck();
+            }
+
+            // [2. 期望值严格比对]
+            if (m_expectedIds.contains(key)) {
+                QString expected = m_expectedIds.value(key);
+
+                if (val != expected) {
+                    // 发现错误：只标记，不退出
+                    m_hasError = true;
+                    stateDirty = true;
+
+                    // 标记严重错误类型
+                    if (key == "IMEI") {
+                        m_isImeiMismatch = true;
+                    }
+
+                    emitLog(QString(">>> ERROR: %1 不匹配!").arg(rule.name));
+                    emitLog(QString("    期望: [%1]").arg(expected));
+                    emitLog(QString("    实际: [%1]").arg(val));
+
+                    // 界面变红
+                    emit channelStatusChanged(false);
+
+                    // 【关键】 绝对不要在这里 emit testFinished 或 return
+                    // 让程序继续跑，直到超时定时器 (或提前判 NG 的宽限期) 触发
+                    requestFailFast(m_config.failFast.onIdentity, QString("%1 不匹配").arg(rule.name));
+                } else {
+                    emitLog(QString(">>> OK: %1 匹配成功").arg(rule.name));
+                }
+            }
+
+            // [2.5 台账查重] 该身份已经在之前的周期/班次 PASS 过
+            if (checkDuplicateIdentity(key, val)) stateDirty = true;
+
+            // [3. 启动超时计时器] (如果没启动；提前判 NG 已结束测试时不再启动)
+            if (m_isTesting && !m_testTimer->isActive()) {
+                int timeoutMs = m_config.timeoutMs;
+                m_testTimer->start(timeoutMs);
+                emitLog(QString(">>> 测试开始，倒计时: %1 秒").arg(timeoutMs/1000.0));
+            }
+
+            // 业务逻辑 (IMEI/IMSI 上报 & SN校验)
+            // IMSI 也上报：主窗口可按扫到的 SN 反查出的 IMSI 认领条码
+            if (key == "IMEI" || key == "IMSI") emit identityReported(val);
+
+            if (key == "IMSI") {
+                if (m_snManager && m_config.snCheckEnabled) {
+                    QString outSn;
+                    bool isLegit = m_snManager->checkIdentity(val, outSn);
+
+                    // 【逻辑分支 A】: 合法设备 (白名单校验通过)
+                    if (isLegit) {
+                        // 收到正确数据，尝试"挽救"混料/非法设备导致的错误状态
+                        // (重复身份单独记在 m_duplicateIdentity，不在挽救范围内)
+                        if (m_isImeiMismatch) {
+                            m_hasError = false;
+                            m_isImeiMismatch = false;
+                            stateDirty = true;
+                            emitLog(">>> Info: 收到正确数据，错误状态已清除");
+                        }
+
+                        // 关联 SN
+                        if (!outSn.isEmpty()) {
+                            m_currentIds.insert("SN", outSn);
+                            if (checkDuplicateIdentity("SN", outSn)) stateDirty = true;
+
+                            // 白名单查出的 SN 是否与文件里期望的 SN 一致？
+                            if (m_expectedIds.contains("SN")) {
+                                if (m_expectedIds.value("SN") != outSn) {
+                                    m_hasError = true;
+                                    stateDirty = true;
+                                    emitLog(">>> Error: SN 不匹配 (白名单 vs 文件)");
+                                    requestFailFast(m_config.failFast.onSn, "SN 不匹配");
+                                }
+                            }
+                        }
+
+                        updateSerialDisplay();
+                    }
+                    // 【逻辑分支 B】: 非法设备 (不在白名单)
+                    else {
+                        m_hasError = true;
+                        m_isImeiMismatch = true;
+                        stateDirty = true;
+
+                        emitLog(QString(">>> Error: 非法 IMSI: %1 (不在白名单)").arg(val));
+
+                        // 立即刷新界面 (变红)，不中断测试，允许重复接收
+                        updateSerialDisplay();
+                        requestFailFast(m_config.failFast.onWhitelist, "非法 IMSI");
+                    }
+                }
+            }
+
+            // 处理完这一行就跳出循环
+            break;
+        }
+    }
+
+    if (stateDirty) emitState();
+
+    // D. 尝试判定结果 (仅当无错误时才尝试提前 Pass)
+    if (anyUpdate && !m_hasError && !m_duplicateIdentity) {
+        performComparison();
+    }
+}
+
+// ====================================================================
+// 5. 动态显示与比对
+// ====================================================================
+void ChannelWorker::updateSerialDisplay()
+{
+    QStringList displayParts;
+
+    // 1. 构造串口数据显示内容
+    for(const auto& rule : m_config.identityRules) {
+        QString searchKey = rule.key.toUpper();
+        if(m_currentIds.contains(searchKey)) {
+            displayParts << QString("%1:%2").arg(searchKey, m_currentIds[searchKey]);
+        }
+    }
+
+    // 2. 颜色判定：默认灰色 (等待数据)
+    int style = Display_Idle;
+
+    // A. 如果已经出现了明确的错误 (如超时、混料、重复身份) -> 红色
+    if (m_hasError || m_duplicateIdentity) {
+        style = Display_Error;
+    }
+    // B. 如果有期望值 -> 比较 期望值 vs 实际值
+    else if (!m_expectedIds.isEmpty()) {
+        bool allMatched = true;
+        for(auto it = m_expectedIds.constBegin(); it != m_expectedIds.constEnd(); ++it) {
+            if (m_currentIds.value(it.key()) != it.value()) {
+                allMatched = false;
+                break;
+            }
+        }
+        if (allMatched) style = Display_Ok;
+    }
+    // C. 如果没有期望值 (盲测模式) -> 只要有数据就暂定为绿色
+    else if (!m_currentIds.isEmpty()) {
+        style = Display_Ok;
+    }
+
+    emit serialDisplayChanged(displayParts.join(" "), style);
+}
+
+void ChannelWorker::updateResultItem(QLatin1String key, QLatin1String val)
+{
+    // 编译好的规则表：一次哈希 + 一次 memcmp 定位规则
+    const TelemetryRuleTable *table = m_config.telemetryTable.data();
+    if (!table) return;
+    int index = table->indexOf(key);
+    if (index < 0) return;
+
+    if (table->rule(index).type == Type_Display) {
+        setResultItem(index, Item_Display, val);
+        return;
+    }
+    if (m_result.isPass(index)) return;
+
+    setResultItem(index, table->passes(index, val) ? Item_Ok : Item_Ng, val);
+}
+
+void ChannelWorker::updateResultItem(const QString &key, const QString &val)
+{
+    // 旧解析路径：转回字节后复用同一套判定
+    QByteArray k = key.toLocal8Bit();
+    QByteArray v = val.toLocal8Bit();
+    updateResultItem(QLatin1String(k.constData(), k.size()), QLatin1String(v.constData(), v.size()));
+}
+
+void ChannelWorker::setResultItem(int index, int state, QLatin1String val)
+{
+    // 状态和值都没变：不发信号，也不构造 QString (按原始字节比较，非 ASCII 的值也成立)
+    const QByteArray &last = m_itemValues.at(index);
+    if (itemState(index) == state && last.size() == val.size()
+            && (val.size() == 0 || memcmp(last.constData(), val.data(), size_t(val.size())) == 0)) return;
+
+    if (state == Item_Ok) m_result.markPass(index);
+    else if (state == Item_Ng) m_result.markNg(index);
+    else m_result.markReceived(index);
+
+    m_itemValues[index] = QByteArray(val.data(), val.size());
+    emit resultItemChanged(index, state, QString::fromLocal8Bit(val.data(), val.size()));
+
+    if (state == Item_Ng && m_result.anyNgIn(m_failFastMask)) {
+        requestFailFast(true, QString("%1 NG").arg(m_config.telemetryTable->rule(index).name), false);
+    }
+}
+
+int ChannelWorker::itemState(int index) const
+{
+    if (m_result.isPass(index)) return Item_Ok;
+    if (m_result.isNg(index)) return Item_Ng;
+    if (m_result.isReceived(index)) return Item_Display;
+    return Item_Wait;
+}
+
+void ChannelWorker::performComparison()
+{
+    // 步骤 A: 检查 "身份期望值" (源自 D:/SN.txt)
+    bool identityPass = true;
+
+    if (!m_expectedIds.isEmpty()) {
+        for(auto it = m_expectedIds.constBegin(); it != m_expectedIds.constEnd(); ++it) {
+            QString current = m_currentIds.value(it.key());
+
+            // 1. 没读到
+            if (current.isEmpty()) {
+                identityPass = false;
+                break;
+            }
+
+            // 2. 读到了但不匹配 (parseLine 里已经处理过报错，这里只阻断 Pass)
+            if (current != it.value()) {
+                qDebug() << "   -> [身份] ❌ 不匹配:" << it.key() << "期望:" << it.value() << "实际:" << current;
+                identityPass = false;
+                break;
+            }
+        }
+    }
+
+    // 步骤 B: 检查 "遥测规则" (位图按字比较，不再逐条遍历)
+    bool telemetryAllRecv = m_result.allReceived(); // 遥测数据是否齐了
+    bool telemetryHasNG = m_result.anyNg();         // 是否有 NG 项
+
+    // 步骤 C: 最终综合判定
+    if (!m_hasError && !m_duplicateIdentity && identityPass && telemetryAllRecv && !telemetryHasNG) {
+
+        qDebug() << ">>> [结果] ✅ Channel" << m_id << "所有条件满足 -> 触发 PASS";
+
+        // 1. 停止倒计时
+        if (m_testTimer->isActive()) m_testTimer->stop();
+        m_failFastTimer->stop();
+        m_noSignalTimer->stop();
+
+        // 2. 锁定，防止后续数据干扰
+        m_isTesting = false;
+        emitState();
+
+        // 3. 登记身份台账，界面变绿并上报
+        recordPassedIdentities();
+        emit channelStatusChanged(true);
+        emit testFinished(true, Reason_None);
+
+        emitLog(">>> 最终结果: PASS (提前完成)");
+        reportParseStats();
+        syncLogFile();
+    }
+    // 否则：不做任何操作，继续等待下一次串口数据或超时
+}
+
+void ChannelWorker::parseTelemetry(QLatin1String dataPart)
+{
+    // 原始数据示例: "... v:4.211,t:0.776,35,pwr:1 ..."
+    bool anyUpdate = TelemetryTokenizer::tokenize(dataPart, [this](QLatin1String key, QLatin1String val) {
+        updateResultItem(key, val);
+    });
+
+    if(anyUpdate) performComparison();
+}
+
+// 旧的 QString 解析 (配置 telemetry_fast_path=false 时使用，便于对比耗时)
+void ChannelWorker::parseTelemetryLegacy(const QString &dataPart)
+{
+    // 原始数据示例: "... v:4.211,t:0.776,35,pwr:1 ..."
+    const QStringList parts = dataPart.split(',', Qt::SkipEmptyParts);
+
+    bool isNextT2 = false; // 标记位：下一个纯数字是否为 t2
+    bool anyUpdate = false;
+
+    for(const QString &part : parts) {
+        QString cleanPart = part.trimmed();
+
+        // --- 情况 A: 标准的 key:value (例如 t:0.776) ---
+        if(cleanPart.contains(':')) {
+            QStringList kv = cleanPart.split(':');
+            if(kv.size() == 2) {
+                QString key = kv[0].trimmed();
+                QString val = kv[1].trimmed();
+
+                // [特殊处理] 如果检测到 key 是 "t"
+                if(key.compare("t", Qt::CaseInsensitive) == 0) {
+                    // 前半部分映射给 "t1"，下一个没有冒号的数字就是 "t2"
+                    updateResultItem("t1", val);
+                    isNextT2 = true;
+                }
+                else {
+                    updateResultItem(key, val);
+                    isNextT2 = false;
+                }
+                anyUpdate = true;
+            }
+        }
+        // --- 情况 B: 没有冒号的纯数值 (例如 35) ---
+        else if(!cleanPart.isEmpty()) {
+            if(isNextT2) {
+                updateResultItem("t2", cleanPart);
+                isNextT2 = false; // 用完即焚，防止误判
+                anyUpdate = true;
+            }
+        }
+    }
+
+    if(anyUpdate) performComparison();
+}
+
+// ====================================================================
+// 6. 超时处理
+// ====================================================================
+void ChannelWorker::onTestTimeout()
+{
+    // 0. [安全检查] 如果已经不在测试状态，直接退出，防止多次触发
+    if (!m_isTesting) return;
+
+    finishWithFailure(">>> [Timeout] 测试超时！强制停止串口接收。");
+}
+
+// ====================================================================
+// 7. 提前判 NG (fail_fast)
+// ====================================================================
+void ChannelWorker::requestFailFast(bool classEnabled, const QString &why, bool latchError)
+{
+    if (!m_isTesting || !m_config.failFast.enabled || !classEnabled) return;
+
+    // 错误类 (m_hasError) 触发时记下来，宽限期结束后据此复核
+    if (latchError) m_failFastOnError = true;
+
+    // 宽限期已经在走，不重复计时
+    if (m_failFastTimer->isActive()) return;
+
+    int graceMs = m_config.failFast.graceMs;
+    if (graceMs <= 0) {
+        emitLog(QString(">>> [FailFast] %1，立即判定 NG").arg(why));
+        onFailFastTimeout();
+        return;
+    }
+
+    emitLog(QString(">>> [FailFast] %1，%2 ms 内未恢复则判定 NG").arg(why).arg(graceMs));
+    m_failFastTimer->start(graceMs);
+}
+
+void ChannelWorker::onFailFastTimeout()
+{
+    if (!m_isTesting) return;
+
+    // 宽限期内可能已被后续正确数据挽救 (IMSI 白名单恢复 / 遥测项重新合格)
+    bool stillNg = (m_failFastOnError && (m_hasError || m_duplicateIdentity)) || m_result.anyNgIn(m_failFastMask);
+    if (!stillNg) {
+        m_failFastOnError = false;
+        emitLog(">>> [FailFast] 错误已恢复，继续等待");
+        return;
+    }
+
+    finishWithFailure(">>> [FailFast] 结果已无法变为 PASS，提前结束测试。");
+}
+
+// ====================================================================
+// 8. 无信号提前结束 (no_signal)
+// ====================================================================
+void ChannelWorker::scheduleNoSignalCheck()
+{
+    m_noSignalTimer->stop();
+    if (!m_isTesting || !m_cycleClock.isValid()) return;
+
+    // 取最近的一个未满足的期限
+    int deadline = -1;
+    const NoSignalConfig &cfg = m_config.noSignal;
+    if (!m_gotFirstByte && cfg.firstByteMs > 0) deadline = cfg.firstByteMs;
+    if (!m_gotIdentity && cfg.firstIdentityMs > 0 && (deadline < 0 || cfg.firstIdentityMs < deadline)) {
+        deadline = cfg.firstIdentityMs;
+    }
+    if (deadline < 0) return;
+
+    m_noSignalTimer->start(int(qMax<qint64>(0, deadline - m_cycleClock.elapsed())));
+}
+
+void ChannelWorker::onNoSignalTimeout()
+{
+    if (!m_isTesting) return;
+
+    qint64 elapsed = m_cycleClock.elapsed();
+    const NoSignalConfig &cfg = m_config.noSignal;
+
+    if (!m_gotFirstByte && cfg.firstByteMs > 0 && elapsed >= cfg.firstByteMs) {
+        finishWithFailure(QString(">>> [NoSignal] %1 ms 内串口无任何数据 (空工位或设备未上电)").arg(elapsed),
+                          Reason_NoSignal);
+        return;
+    }
+    if (!m_gotIdentity && cfg.firstIdentityMs > 0 && elapsed >= cfg.firstIdentityMs) {
+        finishWithFailure(QString(">>> [NoSignal] %1 ms 内未收到设备身份信息 (设备未正常启动)").arg(elapsed),
+                          Reason_NoSignal);
+        return;
+    }
+
+    // 另一个期限还没到
+    scheduleNoSignalCheck();
+}
+
+// 超时、提前判 NG、无信号共用的失败收尾
+void ChannelWorker::finishWithFailure(const QString &err, int reason)
+{
+    // 1. [核心] 立即锁定状态位
+    m_isTesting = false;
+    m_hasError = true;
+    if (m_testTimer->isActive()) m_testTimer->stop();
+    m_failFastTimer->stop();
+    m_noSignalTimer->stop();
+
+    // 2. 非常驻模式：物理关闭串口，停止接收并释放硬件资源
+    //    常驻模式保持打开，周期间隙的数据在 onSerialReadyRead 中直接丢弃
+    if (!m_config.serialPersistent) {
+        closePort();
+    }
+
+    // 3. 记录日志 (界面 + 文件)
+    emitLog(err);
+
+    LogWriter::instance().write(m_logHandle, err.toUtf8() + "\n");
+    syncLogFile();
+
+    // 4. 确保界面变红
+    emit channelStatusChanged(false);
+    reportParseStats();
+
+    // 5. 确定失败原因 (默认为普通错误：超时/漏测)
+    if (m_isImeiMismatch || m_duplicateIdentity) {
+        reason = Reason_IMEI;   // 之前是因为 IMEI 错 / 重复身份导致的卡死，上报严重错误
+    }
+
+    // 6. 先同步状态，再发送结果 (排队信号保证界面按顺序收到)
+    emitState();
+    emit testFinished(false, reason);
+}
+
+bool ChannelWorker::checkDuplicateIdentity(const QString &key, const QString &val)
+{
+    if (!m_config.ledger.enabled || !m_config.ledger.keys.contains(key)) return false;
+    if (!IdentityLedger::instance().contains(key, val)) return false;
+
+    // 已出厂身份再次出现：改标或重刷的设备，按身份错误处理
+    // 单独锁存：后续白名单校验通过也不能清掉
+    m_hasError = true;
+    m_duplicateIdentity = true;
+    emitLog(QString(">>> ERROR: %1 [%2] 已在之前的测试中 PASS 过 (重复身份)").arg(key, val));
+    emit channelStatusChanged(false);
+    requestFailFast(m_config.failFast.onIdentity, QString("%1 重复").arg(key));
+    return true;
+}
+
+void ChannelWorker::recordPassedIdentities()
+{
+    if (!m_config.ledger.enabled) return;
+
+    IdentityLedger &ledger = IdentityLedger::instance();
+    for (auto it = m_currentIds.constBegin(); it != m_currentIds.constEnd(); ++it) {
+        if (m_config.ledger.keys.contains(it.key())) ledger.record(it.key(), it.value(), m_id);
+    }
+}
+
+void ChannelWorker::reportParseStats()
+{
+    if (m_infoStatLines <= 0) return;
+
+    emitLog(QString(">>> [Stat] $info 解析 %1 行, 平均 %2 ns/行 (%3), 界面日志合并为 %4 条")
+                 .arg(m_infoStatLines)
+                 .arg(m_infoStatNs / m_infoStatLines)
+                 .arg(m_config.telemetryFastPath ? "快速路径" : "旧路径")
+                 .arg(m_config.telemetryFastPath ? m_infoLogBatches : m_infoStatLines));
+}
+
+// 界面日志：先送出已攒下的 $info 行，保证与其他日志的先后顺序
+void ChannelWorker::emitLog(const QString &text)
+{
+    flushInfoLog();
+    emit logLine(text);
+}
+
+// 快速路径的 $info 行按一次串口读取合并：每批只构造一个 QString、跨线程排队一次
+void ChannelWorker::flushInfoLog()
+{
+    if (m_infoLog.isEmpty()) return;
+    emit logLine(QString::fromLocal8Bit(m_infoLog.constData(), m_infoLog.size()));
+    m_infoLog.resize(0);    // reserve 过，不会释放已分配的空间
+    m_infoLogBatches++;
+}
+
+// ====================================================================
+// 9. 日志文件
+// ====================================================================
+void ChannelWorker::createLogFile()
+{
+    // 1. 关闭旧日志
+    closeLogFile();
+
+    // 2. 生成路径 Logs/20260125/Ch1_123045.txt
+    QString dirPath = QString("Logs/%1").arg(QDate::currentDate().toString("yyyyMMdd"));
+    QDir dir;
+    if(!dir.exists(dirPath)) dir.mkpath(dirPath);
+
+    QString fileName = QString("%1/Ch%2_%3.txt")
+                           .arg(dirPath)
+                           .arg(m_id)
+                           .arg(QDateTime::currentDateTime().toString("HHmmss"));
+
+    // 3. 打开新文件 (按配置设置组提交策略)
+    LogWriter &writer = LogWriter::instance();
+    writer.setCommitPolicy(m_config.rawLog.commitMs, m_config.rawLog.commitBytes, m_config.rawLog.durability);
+
+    m_logHandle = writer.open(fileName);
+    if(m_logHandle >= 0) {
+        emitLog(QString(">>> Log: %1").arg(fileName));
+    } else {
+        emitLog(">>> Warning: 创建日志文件失败!");
+    }
+}
+
+void ChannelWorker::closeLogFile()
+{
+    if(m_logHandle >= 0) {
+        LogWriter::instance().close(m_logHandle);
+        m_logHandle = -1;
+    }
+}
+
+// 周期结束：按配置的持久化级别落盘，并输出写入统计
+void ChannelWorker::syncLogFile()
+{
+    if (m_logHandle < 0) return;
+
+    LogWriter &writer = LogWriter::instance();
+    writer.sync(m_logHandle, m_config.rawLog.durability);
+
+    LogWriterStats st = writer.stats();
+    emitLog(QString(">>> [Stat] 日志写入: 排队 %1 字节, 组提交 %2 次, 最近 %3 us, 最大 %4 us")
+                 .arg(st.queuedBytes)
+                 .arg(st.commits)
+                 .arg(st.lastCommitUs)
+                 .arg(st.maxCommitUs));
+}
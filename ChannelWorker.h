@@ -0,0 +1,206 @@
+#ifndef CHANNELWORKER_H
+#define CHANNELWORKER_H
+
+#include <QObject>
+#include <QSerialPort>
+#include <QTimer>
+#include <QMap>
+#include <QVector>
+#include <QFile>
+#include <QElapsedTimer>
+
+#include "ConfigManager.h"
+#include "LineFramer.h"
+#include "ChannelResultState.h"
+#include "TelemetryRuleTable.h"
+
+// 前置声明
+class SnManager;
+
+// ==========================================
+// [新增] 通道配置快照
+// 在 GUI 线程从 ConfigManager 拷贝一份，交给工作线程使用，
+// 避免工作线程直接访问单例 (切换机型时单例会被改写)
+// ==========================================
+struct ChannelTestConfig {
+    QVector<IdentityRule> identityRules;
+    QSharedPointer<const TelemetryRuleTable> telemetryTable;  // 只读共享，不拷贝规则
+    int timeoutMs = 15000;
+    bool snCheckEnabled = false;
+    bool telemetryFastPath = true;
+    bool serialPersistent = true;
+    FailFastPolicy failFast;
+    NoSignalConfig noSignal;
+    RawLogConfig rawLog;
+    IdentityLedgerConfig ledger;
+
+    static ChannelTestConfig fromConfigManager(int channelId = 0) {
+        ConfigManager &cfg = ConfigManager::instance();
+        ChannelTestConfig c;
+        c.identityRules = cfg.getIdentityRules();
+        c.telemetryTable = cfg.getTelemetryTable();
+        c.timeoutMs = cfg.getTestTimeout();
+        c.snCheckEnabled = cfg.isSnVerificationEnabled();
+        c.telemetryFastPath = cfg.isTelemetryFastPathEnabled();
+        c.serialPersistent = cfg.isSerialPersistent();
+        c.failFast = cfg.getFailFastPolicy();
+        c.noSignal = cfg.getNoSignalConfig(channelId);
+        c.rawLog = cfg.getRawLogConfig();
+        c.ledger = cfg.getIdentityLedgerConfig();
+        return c;
+    }
+};
+
+// ==========================================
+// [新增] 启动参数 (由界面线程组装)
+// ==========================================
+struct ChannelTestParams {
+    QString portName;
+    int baudRate = 115200;
+    bool reopenPort = false;  // 手动"开启"按钮：重新创建日志 (非常驻模式下还会重新打开串口)
+    bool armTimer = true;     // PLC 自动启动：立即开始超时倒计时
+    ChannelTestConfig config;
+};
+
+// ==========================================
+// PLC 测试失败原因枚举 (从 DeviceChannelWidget.h 移入，工作线程也要用)
+// ==========================================
+enum FailureReason {
+    Reason_None = 0,    // PASS
+    Reason_Common = 1,  // 超时或其他错误
+    Reason_IMEI = 2,    // 严重的 IMEI 不一致
+    Reason_NoSignal = 3 // 无信号：空工位或设备未上电 (串口无数据 / 无身份)
+};
+
+// ==========================================
+// [新增] 结果表格单元状态 (工作线程 -> 界面)
+// ==========================================
+enum ResultItemState {
+    Item_Wait = 0,
+    Item_Ok,
+    Item_Ng,
+    Item_Display
+};
+
+// ==========================================
+// [新增] 串口读取框的显示样式
+// ==========================================
+enum SerialDisplayStyle {
+    Display_Idle = 0,   // 灰色：等待数据
+    Display_Error,      // 红色：混料/非法
+    Display_Ok          // 绿色：匹配
+};
+
+/**
+ * @brief 通道工作对象
+ * * 运行在每个通道独立的 QThread 中，负责：
+ * 1. 持有串口，接收数据并按行切分。
+ * 2. 解析身份/遥测数据，执行规则判定。
+ * 3. 只把精简后的结果通过排队信号发给界面 (DeviceChannelWidget)。
+ * 界面重绘或弹窗不再拖慢任何通道的解析节奏。
+ */
+class ChannelWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChannelWorker(int id, SnManager *snManager, QObject *parent = nullptr);
+    ~ChannelWorker();
+
+    // 以下接口只能在工作线程中调用 (界面侧通过 QMetaObject::invokeMethod 排队调用)
+    void resetState(const ChannelTestConfig &config);
+    void startTest(const ChannelTestParams &params);
+    void stopTest();
+    void openPort(const QString &portName, int baudRate);   // 会话开始时预先打开 (常驻模式)
+    void setExpectedIdentity(const QString &key, const QString &value);
+    void appendLogNote(const QString &text);
+
+signals:
+    void logLine(const QString &text);
+    void serialDisplayChanged(const QString &text, int style);
+    void resultItemChanged(int index, int state, const QString &val);
+    void channelStatusChanged(bool active);
+    void stateChanged(bool isTesting, bool hasError, bool isImeiMismatch);
+    void testFinished(bool isPass, int failureReason);
+    void identityReported(const QString &idValue);
+
+private slots:
+    void onSerialReadyRead();
+    void onTestTimeout();
+    void onFailFastTimeout();
+    void onSerialError(QSerialPort::SerialPortError error);
+    void onNoSignalTimeout();
+
+private:
+    void applyConfig(const ChannelTestConfig &config);
+    bool ensurePortOpen(const QString &portName, int baudRate, QString *error);
+    void closePort();
+    void beginCycle();
+    void handleLine(QLatin1String raw);
+    void createLogFile();
+    void closeLogFile();
+    void syncLogFile();
+
+    void parseLine(const QString &line);
+    void parseTelemetry(QLatin1String dataPart);
+    void parseTelemetryLegacy(const QString &dataPart);
+
+    void updateSerialDisplay();
+    void updateResultItem(QLatin1String key, QLatin1String val);
+    void updateResultItem(const QString &key, const QString &val);
+    void setResultItem(int index, int state, QLatin1String val);
+    int itemState(int index) const;
+    void performComparison();
+    void requestFailFast(bool classEnabled, const QString &why, bool latchError = true);
+    void finishWithFailure(const QString &err, int reason = Reason_Common);
+    void scheduleNoSignalCheck();
+    bool checkDuplicateIdentity(const QString &key, const QString &val);
+    void recordPassedIdentities();
+    void reportParseStats();
+    void emitLog(const QString &text);
+    void flushInfoLog();
+    void emitState();
+
+private:
+    int m_id;
+    bool m_isTesting = false;
+    bool m_hasError = false;
+    bool m_isImeiMismatch = false;
+    bool m_duplicateIdentity = false;   // 台账查重命中 (本轮锁存，只在 resetState 清除)
+
+    // --- 硬件对象 ---
+    QSerialPort *m_serial;
+    QString m_portName;         // 当前持有的串口 (已在 SerialPortPool 登记)
+    QString m_lastPortName;     // 上一次打开过的串口 (再次打开计为 reopen)
+    quint32 m_generation = 0;   // 测试周期号：每次启动 +1，启动前的残留数据一律丢弃
+    LineFramer m_framer;        // 环形缓冲切行 (替代 QByteArray 缓冲)
+    QTimer *m_testTimer;
+    QTimer *m_failFastTimer;    // 提前判 NG 的宽限期
+    QTimer *m_noSignalTimer;    // 首字节 / 首个身份的期限
+    QElapsedTimer m_cycleClock; // 从启动沿开始计时
+    bool m_gotFirstByte = false;
+    bool m_gotIdentity = false;
+
+    // 日志文件 (LogWriter 句柄，写盘在共享的写入线程里完成)
+    int m_logHandle = -1;
+
+    // 数据容器
+    ChannelTestConfig m_config;
+    QMap<QString, QString> m_currentIds;   // 读到的
+    QMap<QString, QString> m_expectedIds;  // 期望的
+    ChannelResultState m_result;           // 每条遥测规则的收到/合格/NG 位图
+    QVector<QByteArray> m_itemValues;      // 最近一次发给界面的值的原始字节 (值不变时不重复发送)
+    QVarLengthArray<quint64, 2> m_failFastMask; // NG 后需要提前结束的遥测规则
+    bool m_failFastOnError = false;        // m_hasError 来自启用了提前判 NG 的错误类别
+    qint64 m_lastResetTime = 0;
+
+    // $info 解析耗时统计 (每轮测试结束时输出)
+    qint64 m_infoStatLines = 0;
+    qint64 m_infoStatNs = 0;
+    QByteArray m_infoLog;               // 快速路径攒下、尚未发给界面的 $info 行
+    qint64 m_infoLogBatches = 0;
+
+    SnManager *m_snManager = nullptr;
+};
+
+#endif // CHANNELWORKER_H
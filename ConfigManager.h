@@ -10,10 +10,16 @@
 #include <QDebug>
 #include <QFileInfo>
 #include <QDir>
+#include <QSharedPointer>
+#include <QStringList>
+#include "PlcAddressMap.h"
 
 // --- 定义数据结构 ---
 enum TestType { Type_Match, Type_Range, Type_Exist, Type_NotMatch ,Type_Display };
 
+// 原始日志落盘级别 (见 LogWriter)
+enum LogDurability { Durability_None = 0, Durability_Flush, Durability_Fsync };
+
 struct IdentityRule {
     QString key;
     QString name;
@@ -29,14 +35,57 @@ struct TestRule {
     double minVal;
     double maxVal;
     bool enable;
+    int failFast = -1;  // 单条规则的提前判 NG 开关：-1 跟随全局 telemetry 类别，0 关，1 开
 };
 
 struct PlcConfig {
     bool enabled;
     QString ip;
     int port;
+    int pipelineDepth;      // 最多同时在途的请求数 (1 = 一问一答)
+    int responseTimeoutMs;  // 单个请求等待应答的时间
+    QString frame;          // 帧格式: ascii1e / binary1e / binary3e
+    PlcAddressMap addressMap = PlcAddressMap::legacy();
+    QString addressMapError;    // address_map 无效时的原因 (addressMap.isValid() 为 false)
+};
+
+// 原始串口日志的组提交策略 (raw_log)
+struct RawLogConfig {
+    int commitMs = 200;             // 最长多久提交一次
+    int commitBytes = 64 * 1024;    // 单通道缓冲超过该大小立即提交
+    int durability = Durability_Flush;
+};
+
+// 提前判 NG 策略 (plc_automation.fail_fast)
+// 结果已经不可能变成 PASS 时，不再等满 test_timeout
+struct FailFastPolicy {
+    bool enabled = false;
+    int graceMs = 0;              // 宽限期：期间收到正确数据可以"挽救" (见 parseLine 的恢复逻辑)
+    bool onIdentity = true;       // 身份期望值不匹配 (D:/SN.txt)
+    bool onWhitelist = true;      // IMSI 不在白名单
+    bool onSn = true;             // 白名单 SN 与文件 SN 不一致
+    bool onTelemetry = true;      // 遥测项 NG (可被单条规则的 fail_fast 覆盖)
+};
+
+// 无信号提前结束 (plc_automation.no_signal)：空工位 / 未上电的设备不必等满超时
+// 两个期限都从 PLC 启动沿开始计时，0 表示不启用
+struct NoSignalConfig {
+    int firstByteMs = 0;          // 期限内串口一个字节都没收到
+    int firstIdentityMs = 0;      // 期限内没有解析出任何身份 (IMEI/IMSI...)
+};
+
+// 已 PASS 身份的持久化台账 (identity_ledger)，防止改标/重刷的设备重复使用身份
+struct IdentityLedgerConfig {
+    bool enabled = false;
+    QString dir = "ledger";                     // 台账目录 (快照 + 追加日志)
+    QStringList keys = { "IMEI", "IMSI", "SN" };  // 参与查重的身份字段
+    int compactRecords = 1000000;               // 追加日志超过这么多条就合并进快照
 };
 
+// 编译后的只读遥测规则表 (见 TelemetryRuleTable.h)
+class TelemetryRuleTable;
+QSharedPointer<const TelemetryRuleTable> compileTelemetryRules(const QVector<TestRule> &rules);
+
 // --- 配置管理器类 ---
 class ConfigManager {
 public:
@@ -103,6 +152,8 @@ public:
 
     QVector<IdentityRule> getIdentityRules() const { return m_identities; }
     QVector<TestRule> getTelemetryRules() const { return m_telemetries; }
+    // 每次加载配置时编译一次，各通道共享同一份只读表
+    QSharedPointer<const TelemetryRuleTable> getTelemetryTable() const { return m_telemetryTable; }
 
     bool isSnVerificationEnabled() {
         if (m_jsonObj.contains("sn_verification")) {
@@ -111,6 +162,11 @@ public:
         return false; // 默认不开启
     }
 
+    // $info 遥测是否走字节级快速解析 (默认开启；设为 false 可切回旧的 QString 解析做对比)
+    bool isTelemetryFastPathEnabled() {
+        return m_jsonObj.value("telemetry_fast_path").toBool(true);
+    }
+
     // 【关键修改 2】 实现获取 PLC 配置的函数
     PlcConfig getPlcConfig() {
         PlcConfig config;
@@ -119,6 +175,9 @@ public:
         config.enabled = true;
         config.ip = "192.168.1.91";
         config.port = 3050;
+        config.pipelineDepth = 4;
+        config.responseTimeoutMs = 3000;
+        config.frame = "ascii1e";
 
         // 尝试从 JSON 读取
         if (m_jsonObj.contains("plc_automation")) {
@@ -128,6 +187,19 @@ public:
             if(plcObj.contains("enabled")) config.enabled = plcObj.value("enabled").toBool();
             if(plcObj.contains("ip"))      config.ip      = plcObj.value("ip").toString();
             if(plcObj.contains("port"))    config.port    = plcObj.value("port").toInt();
+            // "pipeline_depth": 4, "response_timeout": 3000
+            // 老式以太网模块不支持连发时把 pipeline_depth 设为 1
+            if(plcObj.contains("pipeline_depth"))   config.pipelineDepth     = plcObj.value("pipeline_depth").toInt();
+            if(plcObj.contains("response_timeout")) config.responseTimeoutMs = plcObj.value("response_timeout").toInt();
+            // "frame": "binary3e"  (PLC 以太网口的通信数据代码须设为相同格式)
+            if(plcObj.contains("frame"))            config.frame             = plcObj.value("frame").toString();
+            // "address_map": { "slots": 16, "start": "M1600", "release": "M1650",
+            //                  "ok": "D100", "ng": "D101", "alarm": "M1665" }
+            // ok/ng/alarm 可用 M 位或 D 字；同一设备上首尾相接的信号合并成一帧写入
+            if(plcObj.contains("address_map")) {
+                config.addressMap = PlcAddressMap::compile(plcObj.value("address_map").toObject(),
+                                                           &config.addressMapError);
+            }
 
             qDebug() << "PLC 配置已加载 -> IP:" << config.ip << " Port:" << config.port;
         } else {
@@ -145,9 +217,85 @@ public:
         return 15000;
     }
 
+    // "sn_shared_memory": true 时，同一台 PC 上的多个工位进程共用一份 SN 索引
+    bool isSnSharedMemoryEnabled() {
+        return m_jsonObj.value("sn_shared_memory").toBool(false);
+    }
+
+    // 串口是否整个会话常驻打开 (默认开启；设为 false 恢复每轮开关串口的旧行为)
+    bool isSerialPersistent() {
+        return m_jsonObj.value("serial_persistent").toBool(true);
+    }
+
+    // "raw_log": { "commit_ms": 200, "commit_bytes": 65536, "durability": "none" | "flush" | "fsync" }
+    RawLogConfig getRawLogConfig() {
+        RawLogConfig config;
+        QJsonObject obj = m_jsonObj.value("raw_log").toObject();
+        config.commitMs    = obj.value("commit_ms").toInt(config.commitMs);
+        config.commitBytes = obj.value("commit_bytes").toInt(config.commitBytes);
+
+        QString durability = obj.value("durability").toString("flush");
+        if (durability == "none")       config.durability = Durability_None;
+        else if (durability == "fsync") config.durability = Durability_Fsync;
+        else                            config.durability = Durability_Flush;
+        return config;
+    }
+
+    // "no_signal": { "first_byte_ms": 800, "first_identity_ms": 3000,
+    //                "channels": { "3": { "first_byte_ms": 1500 } } }
+    NoSignalConfig getNoSignalConfig(int channelId) {
+        NoSignalConfig config;
+        QJsonObject obj = m_jsonObj.value("plc_automation").toObject().value("no_signal").toObject();
+        if (obj.isEmpty()) return config;
+
+        config.firstByteMs     = qMax(0, obj.value("first_byte_ms").toInt(0));
+        config.firstIdentityMs = qMax(0, obj.value("first_identity_ms").toInt(0));
+
+        // 单通道覆盖 (个别工位的设备启动较慢)
+        QJsonObject ch = obj.value("channels").toObject().value(QString::number(channelId)).toObject();
+        if (ch.contains("first_byte_ms"))     config.firstByteMs     = qMax(0, ch.value("first_byte_ms").toInt());
+        if (ch.contains("first_identity_ms")) config.firstIdentityMs = qMax(0, ch.value("first_identity_ms").toInt());
+        return config;
+    }
+
+    // "identity_ledger": { "enabled": true, "dir": "ledger", "keys": ["IMEI", "IMSI", "SN"],
+    //                      "compact_records": 1000000 }
+    IdentityLedgerConfig getIdentityLedgerConfig() {
+        IdentityLedgerConfig config;
+        QJsonObject obj = m_jsonObj.value("identity_ledger").toObject();
+        if (obj.isEmpty()) return config;
+
+        config.enabled = obj.value("enabled").toBool(true);
+        config.dir = obj.value("dir").toString(config.dir);
+        config.compactRecords = qMax(1000, obj.value("compact_records").toInt(config.compactRecords));
+
+        QJsonArray keys = obj.value("keys").toArray();
+        if (!keys.isEmpty()) {
+            config.keys.clear();
+            for (const auto &k : keys) config.keys.append(k.toString().toUpper());
+        }
+        return config;
+    }
+
+    // "fail_fast": { "enabled": true, "grace_ms": 1000, "identity": true, "whitelist": true, "sn": true, "telemetry": true }
+    FailFastPolicy getFailFastPolicy() {
+        FailFastPolicy policy;
+        QJsonObject obj = m_jsonObj.value("plc_automation").toObject().value("fail_fast").toObject();
+        if (obj.isEmpty()) return policy; // 默认关闭，保持等满超时的旧行为
+
+        policy.enabled     = obj.value("enabled").toBool(true);
+        policy.graceMs     = qMax(0, obj.value("grace_ms").toInt(0));
+        policy.onIdentity  = obj.value("identity").toBool(true);
+        policy.onWhitelist = obj.value("whitelist").toBool(true);
+        policy.onSn        = obj.value("sn").toBool(true);
+        policy.onTelemetry = obj.value("telemetry").toBool(true);
+        return policy;
+    }
+
 private:
     QVector<IdentityRule> m_identities;
     QVector<TestRule> m_telemetries;
+    QSharedPointer<const TelemetryRuleTable> m_telemetryTable;
 
     // 【关键修改 3】 新增成员变量，存储完整的 JSON 对象
     QJsonObject m_jsonObj;
@@ -176,6 +324,7 @@ private:
             rule.key = obj.value("key").toString();
             rule.name = obj.value("name").toString();
             rule.enable = true;
+            if (obj.contains("fail_fast")) rule.failFast = obj.value("fail_fast").toBool() ? 1 : 0;
 
             QString typeStr = obj.value("type").toString();
             if (typeStr == "range") {
@@ -200,10 +349,12 @@ private:
             }
             m_telemetries.append(rule);
         }
+
+        m_telemetryTable = compileTelemetryRules(m_telemetries);
     }
 
     // 私有构造，单例模式
-    ConfigManager() {}
+    ConfigManager() { m_telemetryTable = compileTelemetryRules(m_telemetries); }
     ConfigManager(const ConfigManager&) = delete;
     ConfigManager& operator=(const ConfigManager&) = delete;
 };
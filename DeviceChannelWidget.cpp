@@ -9,26 +9,68 @@
 #include <QDateTime>
 #include <QSettings>
 
-DeviceChannelWidget::DeviceChannelWidget(int id, QWidget *parent)
-    : QWidget(parent), m_id(id)
+namespace {
+const int kLogFlushIntervalMs = 50;   // 日志最多每 50 ms 排版一次 (多通道刷屏时界面线程不再被文本排版占满)
+const int kLogMaxBlocks = 3000;       // 日志窗口保留的最大行数
+
+// 样式表和画刷只构造一次，状态切换时直接取用
+const QString &groupStyle(bool active)
+{
+    static const QString ok = "QGroupBox { border: 2px solid green; font-weight: bold; margin-top: 1ex; } QGroupBox::title { subcontrol-origin: margin; subcontrol-position: top center; }";
+    static const QString ng = "QGroupBox { border: 2px solid red; font-weight: bold; margin-top: 1ex; } QGroupBox::title { subcontrol-origin: margin; subcontrol-position: top center; }";
+    return active ? ok : ng;
+}
+
+const QString &serialStyle(int style)
 {
-    m_serial = new QSerialPort(this);
+    // 默认状态：灰色 (等待数据)
+    static const QString idle = "background-color: #F0F0F0; color: #555; border: 1px solid #CCC;";
+    // 明确的错误 (如超时、混料) -> 红色
+    static const QString error = "background-color: #F2DEDE; color: #A94442; font-weight: bold; border: 2px solid red;";
+    // 完全匹配 / 盲测模式有数据 -> 绿色
+    static const QString ok = "background-color: #DFF0D8; color: #3C763D; font-weight: bold; border: 2px solid green;";
+
+    if (style == Display_Error) return error;
+    if (style == Display_Ok) return ok;
+    return idle;
+}
+}
 
+DeviceChannelWidget::DeviceChannelWidget(int id, SnManager *snManager, QWidget *parent)
+    : QWidget(parent), m_id(id), m_snManager(snManager)
+{
     // =============================================================
-    // 【修复 1】 必须在这里 new 出对象，否则后面用的时候程序直接崩
+    // 【新增】 串口收发与解析放到独立线程
+    // 界面线程只负责显示，慢重绘/弹窗不会再拖慢任何通道
     // =============================================================
-    m_snManager = new SnManager(this);
-    // 加载白名单 (确保 configs 目录下有 whitelist.csv，否则校验会失败)
-    m_snManager->loadData("configs/sn_data.csv");
+    m_workerThread = new QThread(this);
+    m_worker = new ChannelWorker(m_id, m_snManager);
+    m_worker->moveToThread(m_workerThread);
+    connect(m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+
+    m_logFlushTimer = new QTimer(this);
+    m_logFlushTimer->setSingleShot(true);
+    m_logFlushTimer->setInterval(kLogFlushIntervalMs);
+    connect(m_logFlushTimer, &QTimer::timeout, this, &DeviceChannelWidget::flushLog);
 
     setupUi();
 
-    m_testTimer = new QTimer(this);
-    m_testTimer->setSingleShot(true);
-    connect(m_testTimer, &QTimer::timeout, this, &DeviceChannelWidget::onTestTimeout);
+    // 工作线程 -> 界面 (跨线程，自动为排队连接)
+    // 日志行先进缓冲，由定时器合并后一次性追加
+    connect(m_worker, &ChannelWorker::logLine, this, &DeviceChannelWidget::appendLog);
+    connect(m_worker, &ChannelWorker::serialDisplayChanged, this, &DeviceChannelWidget::onWorkerSerialDisplay);
+    connect(m_worker, &ChannelWorker::resultItemChanged, this, &DeviceChannelWidget::onWorkerResultItem);
+    connect(m_worker, &ChannelWorker::channelStatusChanged, this, &DeviceChannelWidget::setChannelStatus);
+    connect(m_worker, &ChannelWorker::stateChanged, this, &DeviceChannelWidget::onWorkerStateChanged);
+    connect(m_worker, &ChannelWorker::testFinished, this, &DeviceChannelWidget::onWorkerTestFinished);
+    connect(m_worker, &ChannelWorker::identityReported, this, &DeviceChannelWidget::identityReported);
 
-    // 连接串口信号
-    connect(m_serial, &QSerialPort::readyRead, this, &DeviceChannelWidget::onSerialReadyRead);
+    m_workerThread->start();
+
+    // 常驻串口：会话开始就打开，PLC 启动沿到来时立即开始监听；切换端口/波特率时重新登记
+    preparePort();
+    connect(m_cbPort, &QComboBox::currentTextChanged, this, &DeviceChannelWidget::preparePort);
+    connect(m_cbBaud, &QComboBox::currentTextChanged, this, &DeviceChannelWidget::preparePort);
 
     // =============================================================
     // 【优化】 移除 ConfigManager::instance().loadConfig(...)
@@ -180,7 +222,7 @@ void DeviceChannelWidget::setupUi() {
     m_logView->setMinimumHeight(60);
     m_logView->setMaximumHeight(150);
     m_logView->setFont(QFont("Consolas", 9));
-    m_logView->setMaximumBlockCount(3000);
+    m_logView->setMaximumBlockCount(kLogMaxBlocks);
 
     // --- E. 组装 ---
     groupLayout->addLayout(topLayout);
@@ -192,18 +234,17 @@ void DeviceChannelWidget::setupUi() {
     // --- F. 信号 ---
     connect(btnStart, &QPushButton::clicked, this, &DeviceChannelWidget::onStartClicked);
     connect(btnStop, &QPushButton::clicked, this, &DeviceChannelWidget::onStopClicked);
-    connect(m_serial, &QSerialPort::readyRead, this, &DeviceChannelWidget::onSerialReadyRead);
     connect(m_editBarcode, &QLineEdit::textChanged, this, &DeviceChannelWidget::onBarcodeChanged);
 
     connect(m_cbModel, &QComboBox::currentTextChanged, this, [=](const QString &fileName){
         if (fileName.isEmpty() || fileName == "默认配置") return;
-        m_logView->appendPlainText(QString(">>> Load: %1").arg(fileName));
+        appendLog(QString(">>> Load: %1").arg(fileName));
         ConfigManager::instance().loadConfig(fileName);
         resetUI();
     });
 
     connect(btnClear, &QPushButton::clicked, this, [=](){
-        m_buffer.clear();
+        m_pendingLog.clear();
         m_logView->clear();
         resetUI();
     });
@@ -213,22 +254,18 @@ void DeviceChannelWidget::setupUi() {
 // 2. 界面重置
 // ====================================================================
 void DeviceChannelWidget::resetUI(bool keepBarcode) {
-    // 0. 停止上一轮计时
-    if (m_testTimer->isActive()) {
-        m_testTimer->stop();
-    }
-
-    // 1. 清空数据容器
-    m_expectedIds.clear();
-    m_currentIds.clear();
-    m_buffer.clear();
-    m_mapResRow.clear(); // [修复] 记得清空行索引缓存，否则表格重绘会乱
-
-    // 2. 重置状态
+    // 0~2. 计时器、数据容器、状态位都在工作线程里，排队通知它重置
+    ChannelTestConfig config = ChannelTestConfig::fromConfigManager(m_id);
+    ChannelWorker *worker = m_worker;
+    QMetaObject::invokeMethod(worker, [worker, config]() {
+        worker->resetState(config);
+    }, Qt::QueuedConnection);
+
+    // 界面侧的状态镜像同步清零
     m_hasError = false;
     m_isImeiMismatch = false;
+    m_finishReason = Reason_None;
     m_isTesting = false;
-    m_lastResetTime = QDateTime::currentMSecsSinceEpoch();
 
     // =========================================================
     // 3. 界面元素重置
@@ -236,9 +273,11 @@ void DeviceChannelWidget::resetUI(bool keepBarcode) {
 
     // 3.1 清空串口显示区 (这是必须的，因为是新测试)
     // 先手动清空显示部分，防止 updateSerialDisplay 还有旧缓存
+    m_serialText.clear();
+    m_serialStyle = Display_Idle;
     if(m_editSerialRead) {
         m_editSerialRead->clear();
-        m_editSerialRead->setStyleSheet("background-color: #F0F0F0; color: #555;");
+        updateSerialDisplay();
     }
 
     // =============================================================
@@ -255,9 +294,10 @@ void DeviceChannelWidget::resetUI(bool keepBarcode) {
     // =========================================================
     // 4. 重建表格 (逻辑保持不变)
     // =========================================================
-    auto teleRules = ConfigManager::instance().getTelemetryRules();
+    const TelemetryRuleTable *table = config.telemetryTable.data();
+    int ruleCount = table ? table->size() : 0;
     // 向上取整计算行数
-    int rows = (teleRules.size() + 3) / 4;
+    int rows = (ruleCount + 3) / 4;
 
     m_tableRes->clear();
     m_tableRes->setRowCount(rows);
@@ -265,13 +305,11 @@ void DeviceChannelWidget::resetUI(bool keepBarcode) {
     m_tableRes->setHorizontalHeaderLabels({"项", "值", "项", "值", "项", "值", "项", "值"});
     m_tableRes->verticalHeader()->setVisible(false);
 
-    m_mapResRow.clear();
-
-    for(int i=0; i<teleRules.size(); i++) {
+    for(int i=0; i<ruleCount; i++) {
         int r = i / 4;
         int c_base = (i % 4) * 2;
 
-        QTableWidgetItem *head = new QTableWidgetItem(teleRules[i].name);
+        QTableWidgetItem *head = new QTableWidgetItem(table->rule(i).name);
         head->setBackground(QColor(240, 240, 240)); // 浅灰背景
         head->setFont(QFont("Microsoft YaHei", 9));
         head->setFlags(Qt::ItemIsEnabled); // 设为只读
@@ -283,11 +321,10 @@ void DeviceChannelWidget::resetUI(bool keepBarcode) {
         resItem->setBackground(Qt::white);
         resItem->setForeground(Qt::black);
         m_tableRes->setItem(r, c_base + 1, resItem);
-
-        m_mapResRow[teleRules[i].key] = i;
     }
 
-    // 5. 日志清空
+    // 5. 日志清空 (还没刷出去的旧行一并丢弃)
+    m_pendingLog.clear();
     if(m_logView) {
         m_logView->clear();
         m_logView->appendPlainText("--- 等待开始 ---");
@@ -298,284 +335,105 @@ void DeviceChannelWidget::resetUI(bool keepBarcode) {
 }
 
 // ====================================================================
-// 3. 串口数据处理
+// 3. 工作线程回调 (只做显示)
 // ====================================================================
-void DeviceChannelWidget::onSerialReadyRead() {
-    QByteArray data = m_serial->readAll();
-
-    // ========================================================
-    // [新增] 实时写入文件
-    // ========================================================
-    if (m_logFile && m_logFile->isOpen()) {
-        m_logFile->write(data);
-        m_logFile->flush(); // 立即刷新，防止程序崩溃数据丢失
-    }
-    // ========================================================
+void DeviceChannelWidget::onWorkerSerialDisplay(const QString &text, int style)
+{
+    m_serialText = text;
+    m_serialStyle = style;
+    updateSerialDisplay();
+}
 
-    if (!m_isTesting) {
-        // 可选：把缓冲区读空丢弃，防止下次启动时读到旧数据
-        m_serial->readAll();
-        return;
-    }
+void DeviceChannelWidget::onWorkerResultItem(int index, int state, const QString &val)
+{
+    int row = index / 4;
+    int col = (index % 4) * 2 + 1;
 
-    m_buffer.append(data);
+    QTableWidgetItem *item = m_tableRes->item(row, col);
+    if(!item) return;
 
-    // 防止缓存爆炸 (保留最近 20KB)
-    if(m_buffer.size() > 20480) m_buffer.clear();
+    // 画刷/字体只构造一次
+    static const QBrush displayFg(QColor(0, 0, 200));
+    static const QBrush okBg(Qt::white);
+    static const QBrush okFg(QColor(0, 150, 0));
+    static const QFont okFont("Microsoft YaHei", 9, QFont::Bold);
+    static const QBrush ngBg(QColor(255, 0, 0));
+    static const QBrush ngFg(Qt::white);
+    static const QFont ngFont("Arial", 8);
 
-    processBuffer();
+    if (state == Item_Display) {
+        item->setText(val);
+        item->setForeground(displayFg);
+    }
+    else if (state == Item_Ok) {
+        item->setText("OK");
+        item->setBackground(okBg);
+        item->setForeground(okFg);
+        item->setFont(okFont);
+    }
+    else if (state == Item_Ng) {
+        item->setText(QString("NG (%1)").arg(val));
+        item->setBackground(ngBg);
+        item->setForeground(ngFg);
+        item->setFont(ngFont);
+    }
 }
 
-void DeviceChannelWidget::processBuffer() {
-    while(true) {
-        // 同时查找 \n 和 \r
-        int idxN = m_buffer.indexOf('\n');
-        int idxR = m_buffer.indexOf('\r');
-        int idx = -1;
-
-        // 找最早出现的换行符
-        if (idxN != -1 && idxR != -1) idx = qMin(idxN, idxR);
-        else if (idxN != -1) idx = idxN;
-        else if (idxR != -1) idx = idxR;
-        else break; // 没找到换行符，退出等待更多数据
-
-        // 提取一行
-        QString line = QString::fromLocal8Bit(m_buffer.left(idx)).trimmed();
-
-        // 移除已处理的数据 (包括换行符自己)
-        m_buffer.remove(0, idx + 1);
-
-        if(!line.isEmpty()) {
-            parseLine(line);
-            // 只有非空行才记录日志，避免日志里全是空行
-            m_logView->appendPlainText(line);
-        }
-    }
+void DeviceChannelWidget::onWorkerStateChanged(bool isTesting, bool hasError, bool isImeiMismatch)
+{
+    m_isTesting = isTesting;
+    m_hasError = hasError;
+    m_isImeiMismatch = isImeiMismatch;
+}
+
+void DeviceChannelWidget::onWorkerTestFinished(bool isPass, int failureReason)
+{
+    m_finishReason = failureReason;
+    emit testFinished(m_id, isPass, failureReason);
 }
 
 // ====================================================================
-// 4. 核心解析逻辑 (修复重复重置BUG)
+// 4. 串口读取框显示 (内容与颜色由工作线程判定)
 // ====================================================================
-void DeviceChannelWidget::parseLine(const QString &line) {
-    if(!m_isTesting) return;
-
-    // 预处理
-    QString cleanLine = line.trimmed();
-    if (cleanLine.isEmpty()) return;
-
-    // =======================================================
-    // A. [保留原有功能] 遥测数据处理 ($info)
-    // =======================================================
-    if(cleanLine.contains("$info,")) {
-        int start = cleanLine.indexOf("$info,");
-        // 调用您原有的 parseTelemetry 函数
-        parseTelemetry(cleanLine.mid(start + 6));
-        return;
-    }
-
-    // B. 获取规则
-    const auto idRules = ConfigManager::instance().getIdentityRules();
-    qint64 now = QDateTime::currentMSecsSinceEpoch();
-    bool anyUpdate = false;
-
-    // C. 遍历规则
-    for(const auto& rule : idRules) {
-        if(!rule.enable) continue;
-
-        if(cleanLine.startsWith(rule.prefix, Qt::CaseInsensitive)) {
-            QString key = rule.key.toUpper();
-
-            // 提取值
-            QString val = cleanLine.mid(rule.prefix.length()).trimmed();
-            if (val.startsWith(":")) val = val.mid(1).trimmed();
-            if(val.isEmpty()) continue;
-
-            // [1. 去重机制]
-            if (m_currentIds.value(key) == val) {
-                if (now - m_lastResetTime < 8000) continue;
-            }
-
-            qDebug() << ">>> [Serial Recv] Channel" << m_id << "Got:" << key << "=" << val;
-
-            // =======================================================
-            // 【修改点 1】 立即更新数据和显示 (无论对错)
-            // =======================================================
-            // 这样即使比对失败，界面上也能看到刚刚读到的错误条码
-            m_currentIds.insert(key, val);
-            updateSerialDisplay();
-            anyUpdate = true;
-
-            // [注意] 已移除 emit identityDetected(); 改为 PLC 启动时主动加载
-
-            // =======================================================
-            // [2. 期望值严格比对]
-            // =======================================================
-            if (m_expectedIds.contains(key)) {
-                QString expected = m_expectedIds.value(key);
-
-                if (val != expected) {
-                    // 【修改点 2】 发现错误：只标记，不退出
-                    m_hasError = true;
-
-                    // 标记严重错误类型
-                    if (key == "IMEI") {
-                        m_isImeiMismatch = true;
-                    }
-
-                    // 记录红字日志
-                    m_logView->appendPlainText(QString(">>> ERROR: %1 不匹配!").arg(rule.name));
-                    m_logView->appendPlainText(QString("    期望: [%1]").arg(expected));
-                    m_logView->appendPlainText(QString("    实际: [%1]").arg(val));
-
-                    // 界面变红
-                    setChannelStatus(false);
-
-                    // 【关键】 绝对不要在这里 emit testFinished 或 return
-                    // 让程序继续跑，直到超时定时器触发
-                } else {
-                    m_logView->appendPlainText(QString(">>> OK: %1 匹配成功").arg(rule.name));
-                }
-            }
-
-            // [3. 启动超时计时器] (如果没启动)
-            if (!m_testTimer->isActive()) {
-                int timeoutMs = ConfigManager::instance().getTestTimeout();
-                m_testTimer->start(timeoutMs);
-                m_logView->appendPlainText(QString(">>> 测试开始，倒计时: %1 秒").arg(timeoutMs/1000.0));
-            }
-
-            // =======================================================
-            // [保留原有功能] 业务逻辑 (IMEI上报 & SN校验)
-            // =======================================================
-            if (key == "IMEI") emit identityReported(val);
-
-            // --- SN 校验逻辑 (保留您之前的 SnManager 代码) ---
-            if (key == "IMSI") {
-                bool isSnCheckEnabled = ConfigManager::instance().isSnVerificationEnabled();
-
-                if (m_snManager && isSnCheckEnabled) {
-                    QString outSn;
-                    bool isLegit = m_snManager->checkIdentity(val, outSn);
-
-                    // =================================================================
-                    // 【逻辑分支 A】: 合法设备 (白名单校验通过)
-                    // =================================================================
-                    if (isLegit) {
-                        // 1. 【核心修改】 收到正确数据，尝试“挽救”/“复位”错误状态
-                        // 只有当之前的错误是“混料/非法设备”导致时，才尝试清除
-                        // 这样就实现了“发现错误变红 -> 再次收到正确数据 -> 变绿”的效果
-                        if (m_isImeiMismatch) {
-                            m_hasError = false;       // 清除通用错误标记
-                            m_isImeiMismatch = false; // 清除混料标记
-                            if (m_logView) m_logView->appendPlainText(">>> Info: 收到正确数据，错误状态已清除");
-                        }
-
-                        // 2. 关联 SN
-                        if (!outSn.isEmpty()) {
-                            m_currentIds.insert("SN", outSn);
-
-                            // 3. 进一步检查：白名单查出的 SN 是否与文件里期望的 SN 一致？
-                            if (m_expectedIds.contains("SN")) {
-                                if (m_expectedIds.value("SN") != outSn) {
-                                    // 虽然白名单里有，但不是我们要测的那个（比如扫码扫的是A，串口发的是B）
-                                    m_hasError = true;
-                                    if (m_logView) m_logView->appendPlainText(">>> Error: SN 不匹配 (白名单 vs 文件)");
-                                }
-                            }
-                        }
-
-                        // 4. 刷新界面 (如果 m_hasError 被清除了，这里就会变绿)
-                        updateSerialDisplay();
-                    }
-                    // =================================================================
-                    // 【逻辑分支 B】: 非法设备 (不在白名单)
-                    // =================================================================
-                    else {
-                        // 1. 标记错误
-                        m_hasError = true;
-                        m_isImeiMismatch = true;
-
-                        // 2. 打印日志
-                        if (m_logView) {
-                            m_logView->appendPlainText(QString(">>> Error: 非法 IMSI: %1 (不在白名单)").arg(val));
-                        }
-
-                        // 3. 立即刷新界面 (变红)
-                        updateSerialDisplay();
-
-                        // 4. 【保持之前的修改】 不中断测试，允许重复接收
-                    }
-                }
-            }
-
-            // 处理完这一行就跳出循环
-            break;
-        }
-    }
+void DeviceChannelWidget::updateSerialDisplay()
+{
+    m_editSerialRead->setText(m_serialText);
 
-    // D. 尝试判定结果 (仅当无错误时才尝试提前 Pass)
-    // 如果 m_hasError 为 true，这里即使数据全了也不会进，会一直等到超时
-    if (anyUpdate && !m_hasError) {
-        performComparison();
-    }
+    // 样式没变就不重设样式表 (setStyleSheet 每次都会触发整控件重新 polish)
+    if (m_appliedSerialStyle == m_serialStyle) return;
+    m_appliedSerialStyle = m_serialStyle;
+    m_editSerialRead->setStyleSheet(serialStyle(m_serialStyle));
 }
 
-
 // ====================================================================
-// 5. 动态显示与比对 (已修复大小写问题)
+// 5. 日志合并刷新
 // ====================================================================
-void DeviceChannelWidget::updateSerialDisplay()
+void DeviceChannelWidget::appendLog(const QString &text)
 {
-    QStringList displayParts;
-    const auto idRules = ConfigManager::instance().getIdentityRules();
-
-    // 1. 构造串口数据显示内容
-    for(const auto& rule : idRules) {
-        QString searchKey = rule.key.toUpper();
-        if(m_currentIds.contains(searchKey)) {
-            displayParts << QString("%1:%2").arg(searchKey, m_currentIds[searchKey]);
-        }
-    }
-    QString fullInfo = displayParts.join(" ");
-    m_editSerialRead->setText(fullInfo);
+    m_pendingLog.append(text);
 
-    // =========================================================
-    // 【核心修复】 UI 颜色判定逻辑 (v10.1)
-    // =========================================================
+    // 通道不可见时只保留最后 kLogMaxBlocks 行 (再多也会被日志窗口裁掉)
+    if (m_pendingLog.size() > kLogMaxBlocks) m_pendingLog.removeFirst();
 
-    // 默认状态：灰色 (等待数据)
-    QString style = "background-color: #F0F0F0; color: #555; border: 1px solid #CCC;";
+    if (!m_logFlushTimer->isActive()) m_logFlushTimer->start();
+}
 
-    // A. 如果已经出现了明确的错误 (如超时、混料) -> 红色
-    if (m_hasError) {
-        style = "background-color: #F2DEDE; color: #A94442; font-weight: bold; border: 2px solid red;";
-    }
-    // B. 如果有期望值 (即通过 CSV 映射了关系) -> 比较 期望值 vs 实际值
-    else if (!m_expectedIds.isEmpty()) {
-        bool allMatched = true;
-        // 遍历所有期望的 ID (例如 IMEI)
-        for(auto it = m_expectedIds.begin(); it != m_expectedIds.end(); ++it) {
-            QString key = it.key();
-            QString expVal = it.value(); // 这是从 CSV 查出来的 865...
-
-            // 如果串口还没读到这个 Key，或者读到的值不等于期望值
-            if (m_currentIds.value(key) != expVal) {
-                allMatched = false;
-                break;
-            }
-        }
+void DeviceChannelWidget::flushLog()
+{
+    if (m_pendingLog.isEmpty()) return;
 
-        if (allMatched) {
-            // 完全匹配 -> 绿色
-            style = "background-color: #DFF0D8; color: #3C763D; font-weight: bold; border: 2px solid green;";
-        }
-    }
-    // C. 如果没有期望值 (盲测模式) -> 只要有数据就暂定为绿色，除非有错误
-    else if (!m_currentIds.isEmpty()) {
-        style = "background-color: #DFF0D8; color: #3C763D; font-weight: bold; border: 2px solid green;";
-    }
+    // 不可见的通道不排版，等 showEvent 时一次性刷出
+    if (!m_logView->isVisible()) return;
 
-    m_editSerialRead->setStyleSheet(style);
+    // 一次追加整批：只排版、滚动一次
+    m_logView->appendPlainText(m_pendingLog.join('\n'));
+    m_pendingLog.clear();
+}
+
+void DeviceChannelWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    flushLog();
 }
 
 void DeviceChannelWidget::onBarcodeChanged(const QString &text) {
@@ -587,269 +445,56 @@ void DeviceChannelWidget::onBarcodeChanged(const QString &text) {
 // 6. 辅助函数
 // ====================================================================
 void DeviceChannelWidget::onStartClicked() {
-    // 1. 先关闭旧的（如果有）
-    if(m_serial->isOpen()) m_serial->close();
-
-    // 关闭旧日志文件
-    if(m_logFile) {
-        if(m_logFile->isOpen()) m_logFile->close();
-        delete m_logFile;
-        m_logFile = nullptr;
-    }
-
-    m_serial->setPortName(m_cbPort->currentText());
-    m_serial->setBaudRate(m_cbBaud->currentText().toInt());
+    // 手动开启：界面先重置，再让工作线程重新打开串口并创建日志
+    // 注意：手动模式不立即倒计时，收到第一条身份数据时才开始
+    resetUI();
 
-    if(m_serial->open(QIODevice::ReadWrite)) {
-        m_logView->appendPlainText("--- 端口已打开 ---");
+    ChannelTestParams params;
+    params.portName = m_cbPort->currentText();
+    params.baudRate = m_cbBaud->currentText().toInt();
+    params.reopenPort = true;
+    params.armTimer = false;
+    params.config = ChannelTestConfig::fromConfigManager(m_id);
 
-        // ========================================================
-        // [新增] 创建日志文件逻辑
-        // 路径格式: Logs/20260114/Ch1_123045.txt
-        // ========================================================
-        QString dirPath = QString("Logs/%1").arg(QDate::currentDate().toString("yyyyMMdd"));
-        QDir dir;
-        if(!dir.exists(dirPath)) dir.mkpath(dirPath); // 自动创建目录
+    m_isTesting = true;
+    ChannelWorker *worker = m_worker;
+    QMetaObject::invokeMethod(worker, [worker, params]() {
+        worker->startTest(params);
+    }, Qt::QueuedConnection);
+}
 
-        QString fileName = QString("%1/Ch%2_%3.txt")
-                               .arg(dirPath)
-                               .arg(m_id)
-                               .arg(QDateTime::currentDateTime().toString("HHmmss"));
+void DeviceChannelWidget::preparePort() {
+    if (!ConfigManager::instance().isSerialPersistent()) return;
+    if (m_isTesting) return; // 测试中不切换，下一次启动时 startTest 会按当前选择打开
 
-        m_logFile = new QFile(fileName);
-        if(m_logFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-            m_logView->appendPlainText(QString(">>> Log: %1").arg(fileName));
-        } else {
-            m_logView->appendPlainText(">>> Warning: 创建日志文件失败!");
-        }
-        // ========================================================
-        resetUI();
-        m_isTesting = true;
-    } else {
-        m_logView->appendPlainText("错误: 打开串口失败!");
-    }
+    QString portName = m_cbPort->currentText();
+    int baudRate = m_cbBaud->currentText().toInt();
+    ChannelWorker *worker = m_worker;
+    QMetaObject::invokeMethod(worker, [worker, portName, baudRate]() {
+        worker->openPort(portName, baudRate);
+    }, Qt::QueuedConnection);
 }
 
 // 停止按钮
 void DeviceChannelWidget::onStopClicked() {
-    if(m_serial->isOpen()) {
-        m_serial->close();
-        m_isTesting = false;
-        m_logView->appendPlainText("--- 端口已关闭 ---");
-
-        // [新增] 关闭文件
-        if(m_logFile) {
-            if(m_logFile->isOpen()) m_logFile->close();
-            delete m_logFile;
-            m_logFile = nullptr;
-        }
-
-        setChannelStatus(true);
-    }
+    ChannelWorker *worker = m_worker;
+    QMetaObject::invokeMethod(worker, [worker]() {
+        worker->stopTest();
+    }, Qt::QueuedConnection);
 }
 
 // 析构函数
 DeviceChannelWidget::~DeviceChannelWidget() {
-    if (m_serial->isOpen()) m_serial->close();
-
-    // [新增] 安全关闭文件
-    if (m_logFile) {
-        if (m_logFile->isOpen()) m_logFile->close();
-        delete m_logFile;
-    }
-}
-
-void DeviceChannelWidget::updateResultItem(const QString &key, const QString &val) {
-    if(!m_mapResRow.contains(key)) return;
-    int index = m_mapResRow[key];
-    int row = index / 4;
-    int col = (index % 4) * 2 + 1;
-
-    QTableWidgetItem *item = m_tableRes->item(row, col);
-    if(!item) return;
-
-    auto rules = ConfigManager::instance().getTelemetryRules();
-    if(index >= rules.size()) return;
-    TestRule rule = rules[index];
-
-    if (rule.type == Type_Display) {
-        item->setText(val);
-        item->setForeground(QBrush(QColor(0, 0, 200)));
-        return;
-    }
-    if (item->text() == "OK") return;
-
-    bool pass = false;
-    double numVal = val.toDouble();
-    if(rule.type == Type_Match) pass = (val == rule.targetVal);
-    else if (rule.type == Type_NotMatch) pass = (val != rule.targetVal);
-    else if (rule.type == Type_Range) pass = (numVal >= rule.minVal && numVal <= rule.maxVal);
-    else pass = (val != "0" && !val.isEmpty());
-
-    if(pass) {
-        item->setText("OK");
-        item->setBackground(QBrush(Qt::white));
-        item->setForeground(QBrush(QColor(0, 150, 0)));
-        item->setFont(QFont("Microsoft YaHei", 9, QFont::Bold));
-    } else {
-        item->setText(QString("NG (%1)").arg(val));
-        item->setBackground(QBrush(QColor(255, 0, 0)));
-        item->setForeground(QBrush(Qt::white));
-        item->setFont(QFont("Arial", 8));
-    }
-}
-
-void DeviceChannelWidget::performComparison() {
-    // [DEBUG] 1. 打印时间戳，方便追踪
-    // qDebug() << QString("\n=== [Channel %1] 状态判定 (%2) ===")
-    //                 .arg(m_id)
-    //                 .arg(QDateTime::currentDateTime().toString("HH:mm:ss.zzz"));
-
-    // =================================================================
-    // 步骤 A: 检查 "身份期望值" (源自 D:/SN.txt)
-    // =================================================================
-    bool identityPass = true;
-
-    // 如果有期望值（说明文件加载成功），必须逐个比对
-    if (!m_expectedIds.isEmpty()) {
-        for(auto key : m_expectedIds.keys()) {
-            QString expected = m_expectedIds.value(key);
-            QString current = m_currentIds.value(key); // 当前读到的
-
-            // 1. 没读到
-            if (current.isEmpty()) {
-                // qDebug() << "   -> [身份] 等待获取:" << key;
-                identityPass = false;
-                break;
-            }
-
-            // 2. 读到了但不匹配
-            if (current != expected) {
-                qDebug() << "   -> [身份] ❌ 不匹配:" << key << "期望:" << expected << "实际:" << current;
-                // 注意：这里不强制设 m_hasError，因为 parseLine 里已经处理过报错了
-                // 这里主要用于阻断 Pass
-                identityPass = false;
-                break;
-            }
-        }
-    }
-
-    // =================================================================
-    // 步骤 B: 检查 "遥测规则" (源自 Config / 界面表格)
-    // =================================================================
-    auto rules = ConfigManager::instance().getTelemetryRules();
-    bool telemetryAllRecv = true; // 遥测数据是否齐了
-    bool telemetryHasNG = false;  // 是否有 NG 项
-
-    for(int i = 0; i < rules.size(); ++i) {
-        const auto& rule = rules[i];
-        if(!rule.enable) continue;
-
-        // 获取表格里的状态
-        int row = i / 4;
-        int col = (i % 4) * 2 + 1;
-        QTableWidgetItem *item = m_tableRes->item(row, col);
-        QString currentText = item ? item->text() : "NULL";
-
-        // Display 类型不参与判定
-        if(rule.type == Type_Display) continue;
-
-        // 1. 检查是否等待中
-        if(!item || item->text() == "WAIT" || item->text().isEmpty()) {
-            // qDebug() << "   -> [遥测] 等待数据:" << rule.name;
-            telemetryAllRecv = false;
-            continue;
-        }
-
-        // 2. 检查是否 NG
-        if(item->text().startsWith("NG")) {
-            qDebug() << "   -> [遥测] 发现 NG:" << rule.name << "值:" << item->text();
-            telemetryHasNG = true;
-        }
-    }
-
-    // =================================================================
-    // 步骤 C: 最终综合判定
-    // =================================================================
-    // 判定通过的条件：
-    // 1. 没有任何错误标记 (m_hasError 为 false)
-    // 2. 身份比对全部一致 (identityPass 为 true)
-    // 3. 遥测数据全部收齐 (telemetryAllRecv 为 true)
-    // 4. 遥测没有 NG 项 (telemetryHasNG 为 false)
-
-    if (!m_hasError && identityPass && telemetryAllRecv && !telemetryHasNG) {
-
-        qDebug() << ">>> [结果] ✅ Channel" << m_id << "所有条件满足 -> 触发 PASS";
-
-        // 1. 停止倒计时
-        if (m_testTimer->isActive()) m_testTimer->stop();
-
-        // 2. 界面变绿
-        setChannelStatus(true);
-
-        // 3. 发送信号 (使用 3 参数版本)
-        // 参数: ID, 是否通过, 失败原因(无)
-        emit testFinished(m_id, true, Reason_None);
-
-        m_logView->appendPlainText(">>> 最终结果: PASS (提前完成)");
-        m_isTesting = false; // 锁定，防止后续数据干扰
-    }
-    // 否则：不做任何操作，继续等待下一次串口数据或超时
+    // 退出工作线程：线程结束时 deleteLater 析构 worker (关闭串口和日志文件)
+    m_workerThread->quit();
+    m_workerThread->wait();
 }
 
 void DeviceChannelWidget::setChannelStatus(bool active) {
-    if(active) m_group->setStyleSheet("QGroupBox { border: 2px solid green; font-weight: bold; margin-top: 1ex; } QGroupBox::title { subcontrol-origin: margin; subcontrol-position: top center; }");
-    else m_group->setStyleSheet("QGroupBox { border: 2px solid red; font-weight: bold; margin-top: 1ex; } QGroupBox::title { subcontrol-origin: margin; subcontrol-position: top center; }");
-}
-
-void DeviceChannelWidget::parseTelemetry(const QString &dataPart) {
-    // 原始数据示例: "... v:4.211,t:0.776,35,pwr:1 ..."
-
-    // 1. 先按逗号粗暴分割
-    // 结果变成 list: ["v:4.211", "t:0.776", "35", "pwr:1"]
-    const QStringList parts = dataPart.split(',', Qt::SkipEmptyParts);
-
-    bool isNextT2 = false; // 标记位：下一个纯数字是否为 t2
-    bool anyUpdate = false;
-
-    for(const QString &part : parts) {
-        QString cleanPart = part.trimmed();
-
-        // --- 情况 A: 标准的 key:value (例如 t:0.776) ---
-        if(cleanPart.contains(':')) {
-            QStringList kv = cleanPart.split(':');
-            if(kv.size() == 2) {
-                QString key = kv[0].trimmed();
-                QString val = kv[1].trimmed();
-
-                // [特殊处理] 如果检测到 key 是 "t"
-                if(key.compare("t", Qt::CaseInsensitive) == 0) {
-                    // 1. 把前半部分(0.776) 映射给 "t1"
-                    updateResultItem("t1", val);
-
-                    // 2. 标记：下一个没有冒号的数字，就是 "t2"
-                    isNextT2 = true;
-                }
-                else {
-                    // 其他普通项 (v, pwr, mac...)
-                    updateResultItem(key, val);
-                    isNextT2 = false; // 重置标记
-                }
-                anyUpdate = true;
-            }
-        }
-        // --- 情况 B: 没有冒号的纯数值 (例如 35) ---
-        else if(!cleanPart.isEmpty()) {
-            // 如果上一个项是 t，那这个项肯定是 t2
-            if(isNextT2) {
-                updateResultItem("t2", cleanPart);
-                isNextT2 = false; // 用完即焚，防止误判
-                anyUpdate = true;
-            }
-        }
-    }
-
-    if(anyUpdate) performComparison();
+    // 状态没变就跳过：重设样式表会让整个分组框 (含表格、日志) 重新 polish
+    if (m_appliedStatus == int(active)) return;
+    m_appliedStatus = int(active);
+    m_group->setStyleSheet(groupStyle(active));
 }
 
 ScanResult DeviceChannelWidget::checkScanInput(const QString &code) {
@@ -860,6 +505,13 @@ ScanResult DeviceChannelWidget::checkScanInput(const QString &code) {
         // 如果光标在这个框里，用户非要扫，那就先把码填进去，显示灰色等待
         if(m_editBarcode->hasFocus()) {
             m_editBarcode->setText(code);
+
+            // 扫到的是白名单里的 SN：开机前就反查出设备应有的 IMSI，上报时由工作线程比对
+            QString imsi;
+            if(m_snManager && m_snManager->findImsiBySn(code, imsi)) {
+                setExpectedIdentity("IMSI", imsi);
+                appendLog(QString(">>> 条码 %1 对应 IMSI %2").arg(code, imsi));
+            }
             return ScanResult::Mismatch; // 暂时算错，或者你可以定义一个 Wait 状态
         }
         return ScanResult::Ignore;
@@ -885,52 +537,6 @@ ScanResult DeviceChannelWidget::checkScanInput(const QString &code) {
     return ScanResult::Ignore;
 }
 
-// DeviceChannelWidget.cpp
-
-void DeviceChannelWidget::onTestTimeout() {
-    // 0. [安全检查] 如果已经不在测试状态，直接退出，防止多次触发
-    if (!m_isTesting) return;
-
-    // 1. [核心] 立即锁定状态位
-    // 必须在做任何其他事情之前设为 false，这能配合 onSerialReadyRead 拦截后续数据
-    m_isTesting = false;
-    m_hasError = true;
-
-    // 2. [核心] 物理关闭串口
-    // 这是“停止打印”最有效的手段。不仅停止了接收，也释放了硬件资源。
-    if (m_serial->isOpen()) {
-        m_serial->close();
-    }
-
-    // 3. 记录日志 (界面 + 文件)
-    QString err = ">>> [Timeout] 测试超时！强制停止串口接收。";
-
-    if (m_logView) {
-        m_logView->appendPlainText(err);
-    }
-
-    if (m_logFile && m_logFile->isOpen()) {
-        m_logFile->write(err.toUtf8() + "\n");
-        m_logFile->flush();
-    }
-
-    // 4. 确保界面变红 (Visual Feedback)
-    // 假设 setChannelStatus(false) 会把 GroupBox 变红
-    setChannelStatus(false);
-    // 如果 setChannelStatus 没变色，您可以手动补一句：
-    // m_group->setStyleSheet("QGroupBox { background-color: #ffcccc; }");
-
-    // 5. 确定失败原因
-    int reason = Reason_Common; // 默认为普通错误(超时/漏测)
-
-    if (m_isImeiMismatch) {
-        reason = Reason_IMEI;   // 如果之前是因为 IMEI 错导致的卡死，上报严重错误
-    }
-
-    // 6. 发送信号给 MainWindow 进行最终汇总
-    emit testFinished(m_id, false, reason);
-}
-
 void DeviceChannelWidget::setBarcode(const QString &text)
 {
     // 假设您的 UI 里有一个 m_lineEditScan 或者 m_cbBarcode 用于显示条码
@@ -949,9 +555,11 @@ void DeviceChannelWidget::setBarcode(const QString &text)
 
 void DeviceChannelWidget::setExpectedIdentity(const QString &key, const QString &value)
 {
-    // 转为大写 key 统一存储，防止大小写差异
-    // trimmed() 防止隐形空格
-    m_expectedIds.insert(key.toUpper(), value.trimmed());
+    // 期望值由工作线程比对，排队转发过去 (大小写/空格在那边统一处理)
+    ChannelWorker *worker = m_worker;
+    QMetaObject::invokeMethod(worker, [worker, key, value]() {
+        worker->setExpectedIdentity(key, value);
+    }, Qt::QueuedConnection);
 }
 
 QString DeviceChannelWidget::getBarcode() const {
@@ -971,7 +579,7 @@ void DeviceChannelWidget::startTest(bool keepBarcode)
     // 1. 【防重入检查】 (保持你原有的逻辑)
     // =========================================================
     if (m_isTesting) {
-        if (m_logView) m_logView->appendPlainText(">>> [警告] 测试正在进行中，忽略重复启动请求。");
+        appendLog(">>> [警告] 测试正在进行中，忽略重复启动请求。");
         return;
     }
 
@@ -1000,76 +608,23 @@ void DeviceChannelWidget::startTest(bool keepBarcode)
 
 
     // =========================================================
-    // 3. 【硬件启动逻辑】 (你原有的代码)
+    // 3. 【硬件启动逻辑】 交给工作线程
+    // 打开串口、创建日志、启动超时倒计时都在工作线程里完成
     // =========================================================
+    ChannelTestParams params;
+    params.portName = m_cbPort->currentText();
+    params.baudRate = m_cbBaud->currentText().toInt();
+    params.config = ChannelTestConfig::fromConfigManager(m_id);
 
-    // 确保串口是打开的
-    if (!m_serial->isOpen()) {
-        if (m_cbPort && m_cbBaud) {
-            m_serial->setPortName(m_cbPort->currentText());
-            m_serial->setBaudRate(m_cbBaud->currentText().toInt());
-
-            if (!m_serial->open(QIODevice::ReadWrite)) {
-                // 注意：如果打开失败，这里的 log 可能看不见(因为刚才 resetUI 清空了)
-                // 所以建议 resetUI 时不要清空 logView，或者在这里重新 append
-                if (m_logView) m_logView->appendPlainText(">>> Error: 无法打开串口，测试无法启动!");
-                return;
-            }
-        }
-    }
-
-    // 设置状态位 (落锁)
+    // 设置状态位 (落锁)。若串口打开失败，工作线程会通过 stateChanged 纠正
     m_isTesting = true;
 
-    // 创建日志文件
-    createLogFile();
-
-    if (m_logView) {
-        m_logView->appendPlainText(">>> 测试已启动 (监听串口数据...)");
-    }
-
-    // 启动超时倒计时
-    if (m_testTimer) {
-        int timeoutMs = ConfigManager::instance().getTestTimeout();
-        m_testTimer->start(timeoutMs);
-        if (m_logView) {
-            m_logView->appendPlainText(QString(">>> 超时倒计时已启动: %1 秒").arg(timeoutMs / 1000.0));
-        }
-    }
-}
-
-// ===========================================================================
-    // [防漏补缺] 如果之前没有添加 createLogFile，请把这个也加上
-    // ===========================================================================
-void DeviceChannelWidget::createLogFile() {
-    // 1. 关闭旧日志
-    if(m_logFile) {
-        if(m_logFile->isOpen()) m_logFile->close();
-        delete m_logFile;
-        m_logFile = nullptr;
-    }
-
-    // 2. 生成路径 Logs/20260125/Ch1_123045.txt
-    QString dirPath = QString("Logs/%1").arg(QDate::currentDate().toString("yyyyMMdd"));
-    QDir dir;
-    if(!dir.exists(dirPath)) dir.mkpath(dirPath);
-
-    QString fileName = QString("%1/Ch%2_%3.txt")
-                           .arg(dirPath)
-                           .arg(m_id)
-                           .arg(QDateTime::currentDateTime().toString("HHmmss"));
-
-    // 3. 打开新文件
-    m_logFile = new QFile(fileName);
-    if(m_logFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        if (m_logView) m_logView->appendPlainText(QString(">>> Log: %1").arg(fileName));
-    } else {
-        if (m_logView) m_logView->appendPlainText(">>> Warning: 创建日志文件失败!");
-    }
+    ChannelWorker *worker = m_worker;
+    QMetaObject::invokeMethod(worker, [worker, params]() {
+        worker->startTest(params);
+    }, Qt::QueuedConnection);
 }
 
-    // 在 DeviceChannelWidget.cpp 末尾添加
-
 void DeviceChannelWidget::startTestWithBarcode(const QString &sn)
 {
     // 1. 界面与内部状态重置
@@ -1078,17 +633,16 @@ void DeviceChannelWidget::startTestWithBarcode(const QString &sn)
         m_editBarcode->setText(sn.isEmpty() ? "NO_BARCODE" : sn);
     }
 
-    // 2. 启动测试（内部会调用 resetUI 和 createLogFile）
+    // 2. 启动测试（内部会调用 resetUI，工作线程创建日志文件）
     // 传入 true 表示保留刚才设置的条码显示
     startTest(true);
 
     // 3. 核心逻辑：如果是空条码，立即在日志中记录并判定为 NG
     if (sn.isEmpty()) {
-        if (m_logFile && m_logFile->isOpen()) {
-            QTextStream out(m_logFile);
-            out << "[" << QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss") << "] "
-                << "Error: No barcode received from SN.txt. Terminating as NG." << "\n";
-        }
+        ChannelWorker *worker = m_worker;
+        QMetaObject::invokeMethod(worker, [worker]() {
+            worker->appendLogNote("Error: No barcode received from SN.txt. Terminating as NG.");
+        }, Qt::QueuedConnection);
 
         // 延迟一小会儿汇报，确保 UI 状态更新完整
         QTimer::singleShot(100, this, [this](){
@@ -2,7 +2,7 @@
 #define DEVICECHANNELWIDGET_H
 
 #include <QWidget>
-#include <QSerialPort>
+#include <QThread>
 #include <QSerialPortInfo>
 #include <QPlainTextEdit>
 #include <QTableWidget>
@@ -18,6 +18,7 @@
 #include <QDir>
 
 #include "ConfigManager.h"
+#include "ChannelWorker.h"
 
 // 前置声明
 class SnManager;
@@ -31,21 +32,13 @@ enum class ScanResult {
     Ignore      // 不是这个通道的事 (Pass)
 };
 
-// ==========================================
-// [新增] PLC 测试失败原因枚举
-// ==========================================
-enum FailureReason {
-    Reason_None = 0,    // PASS
-    Reason_Common = 1,  // 超时或其他错误
-    Reason_IMEI = 2     // 严重的 IMEI 不一致
-};
-
 class DeviceChannelWidget : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit DeviceChannelWidget(int id, QWidget *parent = nullptr);
+    // snManager 由主窗口持有、各通道共用 (查表无锁，可跨线程)，须比通道活得久
+    explicit DeviceChannelWidget(int id, SnManager *snManager, QWidget *parent = nullptr);
     ~DeviceChannelWidget();
 
     int id() const { return m_id; }
@@ -54,8 +47,11 @@ public:
         if (!m_hasError) {
             return Reason_None; // 没有错误 -> PASS
         }
-        if (m_isImeiMismatch) {
-            return Reason_IMEI; // 现有的 IMEI 错误标志位为真 -> 严重错误
+        if (m_isImeiMismatch || m_finishReason == Reason_IMEI) {
+            return Reason_IMEI; // IMEI 错误标志位为真或重复身份 -> 严重错误
+        }
+        if (m_finishReason == Reason_NoSignal) {
+            return Reason_NoSignal; // 空工位/未上电
         }
         return Reason_Common;   // 有错误但不是IMEI错 -> 普通错误
     }
@@ -86,50 +82,55 @@ signals:
     void identityReported(const QString &idValue);
 
 private slots:
-    void onSerialReadyRead();
-    void onTestTimeout();
+    // [新增] 工作线程上报的精简状态
+    void onWorkerSerialDisplay(const QString &text, int style);
+    void onWorkerResultItem(int index, int state, const QString &val);
+    void onWorkerStateChanged(bool isTesting, bool hasError, bool isImeiMismatch);
+    void onWorkerTestFinished(bool isPass, int failureReason);
+
+    // [新增] 日志合并刷新
+    void appendLog(const QString &text);
+    void flushLog();
 
     // 按钮槽函数
     void onStartClicked();
     void onStopClicked();
+    void preparePort();
 
     // 扫码框变化槽函数
     void onBarcodeChanged(const QString &text);
 
+protected:
+    void showEvent(QShowEvent *event) override;
+
 private:
     void setupUi();
-    void processBuffer(); // 处理缓冲区
-    void createLogFile(); // 创建日志文件
-
-    void parseLine(const QString &line);
-    void parseTelemetry(const QString &dataPart);
-
     void updateSerialDisplay();
-    void updateResultItem(const QString &key, const QString &val);
-    void performComparison();
     void setChannelStatus(bool active);
 
 private:
     int m_id;
+    // 以下三个标志位是工作线程状态的镜像 (由 stateChanged 信号同步)
     bool m_isTesting = false;
     bool m_hasError = false;
     bool m_isImeiMismatch = false; // 专门记录 IMEI 错误
+    int m_finishReason = Reason_None; // 工作线程上报的结束原因
 
-    // --- 硬件对象 ---
-    QSerialPort *m_serial;
-    QByteArray m_buffer;
-    QTimer *m_testTimer;
+    // --- 工作线程 (持有串口、切行、规则判定) ---
+    QThread *m_workerThread;
+    ChannelWorker *m_worker;
 
-    // 日志文件
-    QFile *m_logFile = nullptr;
+    // 串口读取框最近一次的显示内容
+    QString m_serialText;
+    int m_serialStyle = Display_Idle;
+    int m_appliedSerialStyle = -1;  // 已经应用到控件上的样式 (没变就不重设样式表)
+    int m_appliedStatus = -1;       // 已经应用到分组框上的状态 (0 红 / 1 绿)
 
-    // 数据容器
-    QMap<QString, QString> m_currentIds;   // 读到的
-    QMap<QString, QString> m_expectedIds;  // 期望的
-    QMap<QString, int> m_mapResRow;        // 表格行索引
-    qint64 m_lastResetTime;
+    // 日志合并刷新：工作线程的行先攒在这里，定时一次性追加
+    QStringList m_pendingLog;
+    QTimer *m_logFlushTimer;
 
-    SnManager *m_snManager = nullptr;
+    SnManager *m_snManager = nullptr;  // 主窗口的白名单，不归本通道所有
 
     // --- UI 控件 ---
     QGroupBox *m_group;
@@ -1,4 +1,4 @@
-QT       += core gui serialport widgets network
+QT       += core gui serialport widgets network concurrent
 
 TARGET = ECUTestTool
 TEMPLATE = app
@@ -10,19 +10,39 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 # 源文件列表（请确保您的文件名和这里一致）
 SOURCES += \
+    ChannelWorker.cpp \
     DeviceChannelWidget.cpp \
+    IdentityLedger.cpp \
+    LineFramer.cpp \
+    LogWriter.cpp \
     MainWindow.cpp \
+    McFrameCodec.cpp \
+    PlcAddressMap.cpp \
     PlcController.cpp \
+    SerialPortPool.cpp \
+    SnIndex.cpp \
     SnManager.cpp \
+    TelemetryRuleTable.cpp \
     main.cpp
 
 # 头文件列表
 HEADERS += \
+    ChannelResultState.h \
+    ChannelWorker.h \
     ConfigManager.h \
     DeviceChannelWidget.h \
+    IdentityLedger.h \
+    LineFramer.h \
+    LogWriter.h \
     MainWindow.h \
+    McFrameCodec.h \
+    PlcAddressMap.h \
     PlcController.h \
-    SnManager.h
+    SerialPortPool.h \
+    SnIndex.h \
+    SnManager.h \
+    TelemetryRuleTable.h \
+    TelemetryTokenizer.h
 
 
 
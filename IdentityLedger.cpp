@@ -0,0 +1,305 @@
+#include "IdentityLedger.h"
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+const char kMagic[8] = { 'I', 'D', 'L', 'E', 'D', 'G', 'E', 'R' };
+const quint32 kVersion = 1;
+const int kMinSlots = 1 << 16;
+const int kReadBlockRecords = 65536;   // 重放追加日志时每次读 1MB
+
+// 快照文件头，其后紧跟 slotCount 个 u64 槽
+struct SnapshotHeader {
+    char magic[8];
+    quint32 version;
+    quint32 reserved;
+    quint64 count;
+    quint64 slotCount;
+    quint64 checksum;       // 槽数组的校验值
+};
+
+// 追加日志记录
+struct JournalRecord {
+    quint64 fingerprint;
+    quint32 timeSec;        // 登记时间 (秒)
+    quint16 channel;
+    quint16 reserved;
+};
+
+quint64 checksum(const quint64 *data, qint64 count)
+{
+    quint64 h = 14695981039346656037ull;
+    for (qint64 i = 0; i < count; ++i) h = (h ^ data[i]) * 1099511628211ull;
+    return h;
+}
+
+inline quint64 mix(quint64 h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+}
+
+IdentityLedger::~IdentityLedger()
+{
+    if (m_journal.isOpen()) m_journal.close();
+}
+
+quint64 IdentityLedger::fingerprint(const QString &kind, const QString &value)
+{
+    // FNV-1a 覆盖 "类别:值"，大小写、首尾空格不敏感
+    quint64 h = 14695981039346656037ull;
+    for (QChar c : kind) h = (h ^ c.toUpper().unicode()) * 1099511628211ull;
+    h = (h ^ ':') * 1099511628211ull;
+
+    QString v = value.trimmed();
+    for (QChar c : v) h = (h ^ c.toUpper().unicode()) * 1099511628211ull;
+
+    h = mix(h);
+    return h ? h : 1;
+}
+
+bool IdentityLedger::open(const QString &dir, int compactRecords)
+{
+    QWriteLocker locker(&m_lock);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (m_journal.isOpen()) m_journal.close();
+    m_slots.clear();
+    m_count = 0;
+    m_journalRecords = 0;
+    m_dir = dir;
+    m_compactRecords = compactRecords;
+
+    if (!QDir().mkpath(dir)) {
+        qWarning() << "IdentityLedger: 无法创建目录" << dir;
+        return false;
+    }
+
+    QString tblPath = QDir(dir).filePath("identities.tbl");
+    QString logPath = QDir(dir).filePath("identities.log");
+
+    // 1. 快照：一次读入整个槽数组
+    if (!loadSnapshot(tblPath)) {
+        m_slots.fill(0, kMinSlots);
+        m_count = 0;
+    }
+
+    // 2. 重放追加日志 (残缺的末尾记录会被截掉)
+    if (!replayJournal(logPath)) return false;
+
+    m_stats.loadMs = timer.elapsed();
+    qDebug() << "IdentityLedger: 加载" << m_count << "个身份 (追加日志" << m_journalRecords
+             << "条)，耗时" << m_stats.loadMs << "ms";
+
+    // 3. 追加日志过长：启动时顺便合并，下次启动只需读快照
+    if (m_journalRecords >= m_compactRecords) compactLocked();
+    return true;
+}
+
+bool IdentityLedger::isOpen() const
+{
+    QReadLocker locker(&m_lock);
+    return m_journal.isOpen();
+}
+
+bool IdentityLedger::loadSnapshot(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    SnapshotHeader h;
+    if (file.read(reinterpret_cast<char *>(&h), sizeof(h)) != qint64(sizeof(h))
+            || memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion
+            || h.slotCount < quint64(kMinSlots) || (h.slotCount & (h.slotCount - 1)) != 0
+            || h.slotCount > (quint64(1) << 30) || h.count >= h.slotCount) {
+        qWarning() << "IdentityLedger: 快照无效，忽略" << path;
+        return false;
+    }
+
+    m_slots.resize(int(h.slotCount));
+    qint64 bytes = qint64(h.slotCount) * 8;
+    if (file.read(reinterpret_cast<char *>(m_slots.data()), bytes) != bytes
+            || checksum(m_slots.constData(), qint64(h.slotCount)) != h.checksum) {
+        qWarning() << "IdentityLedger: 快照校验失败，忽略" << path;
+        m_slots.clear();
+        return false;
+    }
+    m_count = qint64(h.count);
+    return true;
+}
+
+bool IdentityLedger::replayJournal(const QString &path)
+{
+    m_journal.setFileName(path);
+    if (!m_journal.open(QIODevice::ReadWrite)) {
+        qWarning() << "IdentityLedger: 无法打开追加日志" << path;
+        return false;
+    }
+
+    qint64 records = m_journal.size() / qint64(sizeof(JournalRecord));
+    QVector<JournalRecord> block(kReadBlockRecords);
+    for (qint64 done = 0; done < records; ) {
+        int n = int(qMin<qint64>(kReadBlockRecords, records - done));
+        qint64 bytes = qint64(n) * qint64(sizeof(JournalRecord));
+        if (m_journal.read(reinterpret_cast<char *>(block.data()), bytes) != bytes) {
+            records = done;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (block.at(i).fingerprint) insert(block.at(i).fingerprint);
+        }
+        done += n;
+    }
+
+    // 掉电留下的半条记录截掉，之后从整条边界追加
+    qint64 validBytes = records * qint64(sizeof(JournalRecord));
+    if (m_journal.size() != validBytes) m_journal.resize(validBytes);
+    m_journal.seek(validBytes);
+    m_journalRecords = records;
+    return true;
+}
+
+bool IdentityLedger::find(quint64 fp) const
+{
+    if (m_slots.isEmpty()) return false;
+
+    const quint64 mask = quint64(m_slots.size() - 1);
+    for (quint64 i = fp & mask; ; i = (i + 1) & mask) {
+        quint64 cur = m_slots.at(int(i));
+        if (cur == fp) return true;
+        if (cur == 0) return false;
+    }
+}
+
+bool IdentityLedger::insert(quint64 fp)
+{
+    // 装载率保持在 0.7 以下，线性探测的平均探测长度很短
+    if ((m_count + 1) * 10 > qint64(m_slots.size()) * 7) grow();
+
+    const quint64 mask = quint64(m_slots.size() - 1);
+    for (quint64 i = fp & mask; ; i = (i + 1) & mask) {
+        quint64 &cur = m_slots[int(i)];
+        if (cur == fp) return false;
+        if (cur == 0) {
+            cur = fp;
+            m_count++;
+            return true;
+        }
+    }
+}
+
+void IdentityLedger::grow()
+{
+    QVector<quint64> old;
+    old.swap(m_slots);
+    m_slots.fill(0, qMax(kMinSlots, old.size() * 2));
+
+    const quint64 mask = quint64(m_slots.size() - 1);
+    for (quint64 fp : old) {
+        if (!fp) continue;
+        quint64 i = fp & mask;
+        while (m_slots.at(int(i)) != 0) i = (i + 1) & mask;
+        m_slots[int(i)] = fp;
+    }
+}
+
+bool IdentityLedger::contains(const QString &kind, const QString &value)
+{
+    quint64 fp = fingerprint(kind, value);
+
+    QReadLocker locker(&m_lock);
+    if (!find(fp)) return false;
+
+    m_duplicates.fetchAndAddRelaxed(1);
+    return true;
+}
+
+bool IdentityLedger::record(const QString &kind, const QString &value, int channelId)
+{
+    if (value.trimmed().isEmpty()) return false;
+    quint64 fp = fingerprint(kind, value);
+
+    QWriteLocker locker(&m_lock);
+    if (!m_journal.isOpen() || !insert(fp)) return false;
+
+    // 每条记录直接写入并 flush：身份每个设备只登记一次，开销可以忽略
+    JournalRecord rec;
+    rec.fingerprint = fp;
+    rec.timeSec = quint32(QDateTime::currentSecsSinceEpoch());
+    rec.channel = quint16(channelId);
+    rec.reserved = 0;
+    m_journal.write(reinterpret_cast<const char *>(&rec), sizeof(rec));
+    m_journal.flush();
+    m_journalRecords++;
+    return true;
+}
+
+bool IdentityLedger::needsCompaction() const
+{
+    QReadLocker locker(&m_lock);
+    return m_journal.isOpen() && m_journalRecords >= m_compactRecords;
+}
+
+bool IdentityLedger::compact()
+{
+    QWriteLocker locker(&m_lock);
+    return compactLocked();
+}
+
+bool IdentityLedger::compactLocked()
+{
+    if (!m_journal.isOpen()) return false;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    SnapshotHeader h;
+    memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.reserved = 0;
+    h.count = quint64(m_count);
+    h.slotCount = quint64(m_slots.size());
+    h.checksum = checksum(m_slots.constData(), m_slots.size());
+
+    // 1. 新快照写临时文件再改名，旧快照在提交前一直有效
+    QSaveFile out(QDir(m_dir).filePath("identities.tbl"));
+    qint64 bytes = qint64(m_slots.size()) * 8;
+    bool ok = out.open(QIODevice::WriteOnly)
+            && out.write(reinterpret_cast<const char *>(&h), sizeof(h)) == qint64(sizeof(h))
+            && out.write(reinterpret_cast<const char *>(m_slots.constData()), bytes) == bytes
+            && out.commit();
+    if (!ok) {
+        qWarning() << "IdentityLedger: 快照写入失败" << out.errorString();
+        return false;
+    }
+
+    // 2. 快照已包含全部身份，清空追加日志
+    m_journal.resize(0);
+    m_journal.seek(0);
+    m_journalRecords = 0;
+
+    m_stats.lastCompactMs = timer.elapsed();
+    qDebug() << "IdentityLedger: 合并完成，共" << m_count << "个身份，耗时" << m_stats.lastCompactMs << "ms";
+    return true;
+}
+
+IdentityLedgerStats IdentityLedger::stats() const
+{
+    QReadLocker locker(&m_lock);
+    IdentityLedgerStats st = m_stats;
+    st.count = m_count;
+    st.journalRecords = m_journalRecords;
+    st.duplicates = m_duplicates.loadRelaxed();
+    return st;
+}
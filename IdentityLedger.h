@@ -0,0 +1,89 @@
+#ifndef IDENTITYLEDGER_H
+#define IDENTITYLEDGER_H
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+#include <QReadWriteLock>
+#include <QAtomicInteger>
+
+// ==========================================
+// 身份台账统计
+// ==========================================
+struct IdentityLedgerStats {
+    qint64 count = 0;           // 台账中的身份数
+    qint64 journalRecords = 0;  // 追加日志中尚未合并进快照的条数
+    qint64 duplicates = 0;      // 本次运行发现的重复身份次数
+    qint64 loadMs = 0;          // 启动加载耗时
+    qint64 lastCompactMs = 0;   // 最近一次合并耗时
+};
+
+/**
+ * @brief 已 PASS 身份的持久化台账 (跨周期、跨班次)
+ * * 每个 PASS 的设备把 IMEI/IMSI/SN 记入台账；之后再出现同一身份即判为重复
+ *   (改标、重刷的设备复用了已出厂的身份)。
+ * * 内存里只存 64 位指纹 (身份类别 + 值的哈希)，开放寻址表，查重 O(1)。
+ *   千万级条目约占 8~16 字节/条；指纹碰撞概率在千万条时约为 1e-5 量级。
+ * * 磁盘上分两部分：
+ *   identities.tbl  快照：直接是哈希表的槽数组，启动时一次读入，无需逐条插入；
+ *   identities.log  追加日志：每条 16 字节 {指纹, 时间, 通道}，启动时重放。
+ *   追加日志超过阈值后合并：写新快照 (QSaveFile 原子替换)，再清空追加日志。
+ *   两步之间掉电只会导致重放重复记录，结果不变。
+ *
+ * 所有接口线程安全：查重走读锁，各通道并发；登记/合并走写锁。
+ */
+class IdentityLedger
+{
+public:
+    static IdentityLedger &instance() {
+        static IdentityLedger ledger;
+        return ledger;
+    }
+
+    // 打开台账目录并加载 (程序启动时调用一次)；追加日志过长时顺便合并
+    bool open(const QString &dir, int compactRecords);
+    bool isOpen() const;
+
+    // 该身份是否已经 PASS 过 (同时累计重复计数)
+    bool contains(const QString &kind, const QString &value);
+
+    // 登记一个 PASS 的身份；已存在时返回 false
+    bool record(const QString &kind, const QString &value, int channelId);
+
+    // 追加日志是否该合并了 / 执行合并 (耗时与台账大小成正比，宜在空闲时调用)
+    bool needsCompaction() const;
+    bool compact();
+
+    IdentityLedgerStats stats() const;
+
+private:
+    IdentityLedger() {}
+    ~IdentityLedger();
+    IdentityLedger(const IdentityLedger&) = delete;
+    IdentityLedger& operator=(const IdentityLedger&) = delete;
+
+    static quint64 fingerprint(const QString &kind, const QString &value);
+
+    bool loadSnapshot(const QString &path);
+    bool replayJournal(const QString &path);
+    bool insert(quint64 fp);
+    bool find(quint64 fp) const;
+    void grow();
+    bool compactLocked();
+
+private:
+    mutable QReadWriteLock m_lock;
+
+    QVector<quint64> m_slots;   // 0 为空，槽数为 2 的幂
+    qint64 m_count = 0;
+
+    QString m_dir;
+    QFile m_journal;
+    qint64 m_journalRecords = 0;
+    int m_compactRecords = 1000000;
+
+    IdentityLedgerStats m_stats;
+    QAtomicInteger<qint64> m_duplicates;    // 查重走读锁，计数单独用原子量
+};
+
+#endif // IDENTITYLEDGER_H
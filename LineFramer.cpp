@@ -0,0 +1,121 @@
+#include "LineFramer.h"
+#include <cstring>
+
+LineFramer::LineFramer(int capacity)
+{
+    int cap = 64;
+    while (cap < capacity) cap <<= 1;
+
+    m_ring.resize(cap);
+    m_scratch.reserve(cap);
+    m_mask = quint64(cap - 1);
+}
+
+void LineFramer::clear()
+{
+    m_head = m_scan = m_tail = 0;
+    m_skipLf = false;
+    m_discarding = false;
+}
+
+char *LineFramer::writeSpan(int *maxLen)
+{
+    quint64 freeBytes = (m_mask + 1) - (m_tail - m_head);
+    quint64 toEnd = (m_mask + 1) - (m_tail & m_mask);
+    *maxLen = int(qMin(freeBytes, toEnd));
+    return m_ring.data() + (m_tail & m_mask);
+}
+
+void LineFramer::commit(int len)
+{
+    if (len > 0) m_tail += quint64(len);
+}
+
+int LineFramer::append(const char *data, int len)
+{
+    int written = 0;
+    while (written < len) {
+        int room = 0;
+        char *dst = writeSpan(&room);
+        if (room <= 0) break;
+
+        int n = qMin(room, len - written);
+        memcpy(dst, data + written, size_t(n));
+        commit(n);
+        written += n;
+    }
+    return written;
+}
+
+QLatin1String LineFramer::view(quint64 begin, quint64 end)
+{
+    int len = int(end - begin);
+    int start = int(begin & m_mask);
+    int cap = int(m_mask + 1);
+
+    // 绝大多数行都在一段连续内存里，直接返回视图
+    if (start + len <= cap) {
+        return QLatin1String(m_ring.constData() + start, len);
+    }
+
+    // 跨越环尾：拼接到临时区 (容量已预留，不会再分配)
+    int first = cap - start;
+    m_scratch.resize(len);
+    memcpy(m_scratch.data(), m_ring.constData() + start, size_t(first));
+    memcpy(m_scratch.data() + first, m_ring.constData(), size_t(len - first));
+    return QLatin1String(m_scratch.constData(), len);
+}
+
+bool LineFramer::nextLine(QLatin1String *line)
+{
+    const char *ring = m_ring.constData();
+
+    while (m_scan < m_tail) {
+        char c = ring[m_scan & m_mask];
+
+        // CRLF：CR 已经结束了上一行，紧随其后的 LF 直接吃掉
+        if (m_skipLf) {
+            m_skipLf = false;
+            if (c == '\n' && m_scan == m_head) {
+                m_head = ++m_scan;
+                continue;
+            }
+        }
+
+        if (c != '\n' && c != '\r') {
+            ++m_scan;
+            continue;
+        }
+
+        quint64 end = m_scan++;
+        m_skipLf = (c == '\r');
+
+        if (m_discarding) {
+            // 超长行的剩余部分到此结束，丢弃后恢复正常切分
+            m_droppedBytes += end - m_head;
+            m_head = m_scan;
+            m_discarding = false;
+            continue;
+        }
+
+        *line = view(m_head, end);
+        m_head = m_scan;
+        return true;
+    }
+
+    // 没有完整的行
+    if (m_discarding) {
+        // 丢弃模式下不保留任何数据，立即腾出空间
+        m_droppedBytes += m_tail - m_head;
+        m_head = m_tail;
+    }
+    else if (m_tail - m_head > m_mask) {
+        // 缓冲区被一整行塞满仍没有换行符：整行丢弃并计数，
+        // 直到下一个换行符之前的数据都属于这一行，一并丢弃
+        ++m_overflowCount;
+        m_droppedBytes += m_tail - m_head;
+        m_head = m_tail;
+        m_discarding = true;
+    }
+    return false;
+}
@@ -0,0 +1,64 @@
+#ifndef LINEFRAMER_H
+#define LINEFRAMER_H
+
+#include <QByteArray>
+#include <QLatin1String>
+
+/**
+ * @brief 串口行切分器 (固定容量环形缓冲区)
+ * * 替代 QByteArray::indexOf + remove 的旧写法：
+ * 1. 每个字节只扫描一次，突发大量数据时仍是 O(n)。
+ * 2. CR / LF / CRLF 都视为一个换行符 (CRLF 不会多出一个空行)。
+ * 3. nextLine 返回指向缓冲区内部的视图，不拷贝；只有跨越环尾的行才拼接到临时区。
+ * 4. 单行超过容量时整行丢弃并计数，不会把半截数据当成一行交给解析。
+ *
+ * 非线程安全，只在所属通道的工作线程中使用。
+ */
+class LineFramer
+{
+public:
+    // capacity 会向上取整到 2 的幂
+    explicit LineFramer(int capacity = 32768);
+
+    // 清空缓冲数据 (统计计数保留)
+    void clear();
+
+    // --- 写入侧 ---
+    // 获取一段连续的空闲空间，调用方直接 read 进来后用 commit 提交
+    char *writeSpan(int *maxLen);
+    void commit(int len);
+    // 便捷接口：拷贝写入，返回实际写入的字节数
+    int append(const char *data, int len);
+
+    // --- 读取侧 ---
+    // 取出下一行 (不含换行符)。视图在下一次写入之前有效。
+    bool nextLine(QLatin1String *line);
+
+    int size() const { return int(m_tail - m_head); }
+    int capacity() const { return int(m_mask + 1); }
+
+    // 超长行统计
+    quint64 overflowCount() const { return m_overflowCount; }
+    quint64 droppedBytes() const { return m_droppedBytes; }
+
+private:
+    QLatin1String view(quint64 begin, quint64 end);
+
+private:
+    QByteArray m_ring;
+    QByteArray m_scratch;   // 跨越环尾的行在这里拼成连续内存
+    quint64 m_mask;
+
+    // 读/扫描/写 位置均单调递增，取模 (& m_mask) 后才是下标
+    quint64 m_head = 0;     // 当前行起点
+    quint64 m_scan = 0;     // 已扫描到的位置
+    quint64 m_tail = 0;     // 写入位置
+
+    bool m_skipLf = false;      // 上一行以 CR 结尾，紧随的 LF 属于同一个换行符
+    bool m_discarding = false;  // 正在丢弃超长行，直到下一个换行符
+
+    quint64 m_overflowCount = 0;
+    quint64 m_droppedBytes = 0;
+};
+
+#endif // LINEFRAMER_H
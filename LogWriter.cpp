@@ -0,0 +1,197 @@
+#include "LogWriter.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+LogWriter &LogWriter::instance()
+{
+    static LogWriter writer;
+    return writer;
+}
+
+LogWriter::LogWriter()
+{
+    start(QThread::LowPriority);
+}
+
+// 程序退出时：写出全部缓冲、关闭文件后再结束线程
+LogWriter::~LogWriter()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stop = true;
+        m_wake.wakeOne();
+    }
+    wait();
+}
+
+void LogWriter::setCommitPolicy(int intervalMs, int maxBytes, int durability)
+{
+    QMutexLocker locker(&m_mutex);
+    m_intervalMs = qMax(10, intervalMs);
+    m_maxBytes = qMax(4096, maxBytes);
+    m_durability = durability;
+}
+
+int LogWriter::open(const QString &fileName)
+{
+    // 在调用方线程打开，失败可以立即反馈；之后句柄只由写入线程使用
+    QFile *file = new QFile(fileName);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        delete file;
+        return -1;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    int handle = m_nextHandle++;
+    Stream &s = m_streams[handle];
+    s.file = file;
+    s.pending.reserve(m_maxBytes);
+    return handle;
+}
+
+void LogWriter::write(int handle, const char *data, qint64 len)
+{
+    if (handle < 0 || len <= 0) return;
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_streams.find(handle);
+    if (it == m_streams.end() || it->closing) return;
+
+    it->pending.append(data, int(len));
+    m_stats.queuedBytes += len;
+
+    // 大小阈值：不等定时，立即提交
+    if (it->pending.size() >= m_maxBytes && !m_urgent) {
+        m_urgent = true;
+        m_wake.wakeOne();
+    }
+}
+
+void LogWriter::sync(int handle, int durability)
+{
+    if (handle < 0) return;
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_streams.find(handle);
+    if (it == m_streams.end()) return;
+
+    it->syncLevel = qMax(it->syncLevel, durability);
+    m_urgent = true;
+    m_wake.wakeOne();
+}
+
+void LogWriter::close(int handle)
+{
+    if (handle < 0) return;
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_streams.find(handle);
+    if (it == m_streams.end()) return;
+
+    it->closing = true;
+    m_urgent = true;
+    m_wake.wakeOne();
+}
+
+LogWriterStats LogWriter::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void LogWriter::syncToDisk(QFile *file)
+{
+    file->flush();
+#ifdef Q_OS_WIN
+    _commit(file->handle());
+#else
+    ::fsync(file->handle());
+#endif
+}
+
+void LogWriter::run()
+{
+    struct Job {
+        QFile *file;
+        QByteArray data;
+        int syncLevel;
+        bool closing;
+    };
+    QVector<Job> jobs;
+
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        if (!m_urgent && !m_stop) m_wake.wait(&m_mutex, ulong(m_intervalMs));
+        m_urgent = false;
+
+        bool stopping = m_stop;
+        int durability = m_durability;
+
+        // 1. 在锁内只做指针交换，把每个通道的缓冲整块取走
+        jobs.clear();
+        for (auto it = m_streams.begin(); it != m_streams.end(); ) {
+            Stream &s = it.value();
+            if (stopping) s.closing = true;
+
+            if (s.pending.isEmpty() && s.syncLevel < 0 && !s.closing) {
+                ++it;
+                continue;
+            }
+
+            Job job;
+            job.file = s.file;
+            job.data.swap(s.pending);
+            job.syncLevel = s.syncLevel;
+            job.closing = s.closing;
+            s.syncLevel = -1;
+            if (!s.closing) s.pending.reserve(m_maxBytes);
+            jobs.append(job);
+
+            if (s.closing) it = m_streams.erase(it);
+            else ++it;
+        }
+
+        if (jobs.isEmpty()) {
+            if (stopping) break;
+            continue;
+        }
+
+        // 2. 锁外写盘：每个通道一次 write，按持久化级别 flush/fsync
+        locker.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        qint64 bytes = 0;
+
+        for (Job &job : jobs) {
+            if (!job.data.isEmpty()) {
+                job.file->write(job.data);
+                bytes += job.data.size();
+                if (durability >= Durability_Flush) job.file->flush();
+            }
+            if (job.syncLevel >= Durability_Flush) job.file->flush();
+            if (job.syncLevel >= Durability_Fsync) syncToDisk(job.file);
+            if (job.closing) {
+                job.file->close();
+                delete job.file;
+            }
+        }
+        qint64 costUs = timer.nsecsElapsed() / 1000;
+
+        locker.relock();
+        m_stats.queuedBytes -= bytes;
+        m_stats.writtenBytes += bytes;
+        m_stats.commits++;
+        m_stats.lastCommitUs = costUs;
+        m_stats.maxCommitUs = qMax(m_stats.maxCommitUs, costUs);
+
+        if (stopping && m_streams.isEmpty()) break;
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QByteArray>
+#include <QFile>
+
+#include "ConfigManager.h"
+
+// ==========================================
+// 日志写入统计 (供界面/日志输出)
+// ==========================================
+struct LogWriterStats {
+    qint64 queuedBytes = 0;     // 已提交给写入线程但尚未写出的字节
+    qint64 writtenBytes = 0;    // 累计写出的字节
+    qint64 commits = 0;         // 组提交次数
+    qint64 lastCommitUs = 0;    // 最近一次组提交耗时 (write + flush/fsync)
+    qint64 maxCommitUs = 0;     // 最大一次组提交耗时
+};
+
+/**
+ * @brief 全局共享的原始日志写入线程
+ * * 各通道只把串口数据追加到自己的内存缓冲 (加锁拷贝，不做系统调用)。
+ * * 写入线程按时间 (默认 200 ms) 或缓冲大小 (默认 64 KB) 做组提交：
+ *   一次提交里每个通道只有一次 write。
+ * * 周期结束时由通道调用 sync，按持久化级别落盘：
+ *   Durability_None  只保证进入 QFile 缓冲；
+ *   Durability_Flush 每次组提交都交给操作系统，周期结束再 flush 一次；
+ *   Durability_Fsync 在 Flush 基础上，周期结束时 fsync 到磁盘。
+ *
+ * 所有公开接口线程安全。文件句柄打开后只由写入线程访问。
+ */
+class LogWriter : public QThread
+{
+public:
+    static LogWriter &instance();
+
+    // 组提交策略 (全局生效)
+    void setCommitPolicy(int intervalMs, int maxBytes, int durability);
+
+    // 打开日志文件，返回句柄；失败返回 -1
+    int open(const QString &fileName);
+    void write(int handle, const char *data, qint64 len);
+    void write(int handle, const QByteArray &data) { write(handle, data.constData(), data.size()); }
+
+    // 周期结束：尽快写出该句柄的缓冲并按 durability 落盘 (异步，不阻塞调用方)
+    void sync(int handle, int durability);
+    // 写出剩余数据后关闭 (异步)
+    void close(int handle);
+
+    LogWriterStats stats() const;
+
+protected:
+    void run() override;
+
+private:
+    LogWriter();
+    ~LogWriter();
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    static void syncToDisk(QFile *file);
+
+    struct Stream {
+        QFile *file = nullptr;
+        QByteArray pending;     // 待写数据
+        int syncLevel = -1;     // 周期结束请求的落盘级别 (-1 无)
+        bool closing = false;
+    };
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QHash<int, Stream> m_streams;
+    int m_nextHandle = 1;
+    bool m_urgent = false;      // 有通道缓冲超过阈值 / 请求落盘，立即提交
+    bool m_stop = false;
+
+    int m_intervalMs = 200;
+    int m_maxBytes = 64 * 1024;
+    int m_durability = Durability_Flush;
+
+    LogWriterStats m_stats;
+};
+
+#endif // LOGWRITER_H
@@ -12,7 +12,9 @@
 #include <QDebug>
 #include <QTextCodec>
 #include <QThread>
+#include <QtConcurrent>
 #include "ConfigManager.h" // 必须包含
+#include "IdentityLedger.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -103,9 +105,9 @@ MainWindow::MainWindow(QWidget *parent)
     // =======================================================
 
     // --- [SN 管理器] ---
-    // 注意：DeviceChannelWidget 内部有自己的 SnManager，
-    // 这里保留它是为了 MainWindow 可能需要的全局校验或文件读取。
+    // 全局唯一：扫码反查与各通道的白名单校验共用这一份 (只有一个文件监视和后台重建)
     m_snManager = new SnManager(this);
+    m_snManager->setSharedMemoryEnabled(ConfigManager::instance().isSnSharedMemoryEnabled());
     QString snPath = "configs/sn_data.csv";
 
     if(m_snManager->loadData(snPath)) {
@@ -114,6 +116,14 @@ MainWindow::MainWindow(QWidget *parent)
         qDebug() << "Warning: SN Data load failed or file missing.";
     }
 
+    // --- [身份台账] --- 已 PASS 的 IMEI/IMSI/SN，跨班次查重 (各通道共用)
+    IdentityLedgerConfig ledgerCfg = ConfigManager::instance().getIdentityLedgerConfig();
+    if (ledgerCfg.enabled) {
+        if (!IdentityLedger::instance().open(ledgerCfg.dir, ledgerCfg.compactRecords)) {
+            qDebug() << "Warning: Identity ledger open failed, duplicate check disabled.";
+        }
+    }
+
     // --- [PLC 控制器] ---
     m_plc = new PlcController(this);
 
@@ -139,6 +149,9 @@ MainWindow::MainWindow(QWidget *parent)
     // ============================================================
     connect(m_plc, &PlcController::plcStopSignalReceived, this, &MainWindow::onPlcStopSignal);
 
+    // [新增] 批量写入的应答确认 (结果写入后才放行)
+    connect(m_plc, &PlcController::batchWritten, this, &MainWindow::onPlcBatchWritten);
+
     // --- [读取 PLC 配置并启动] ---
     // 此时 ConfigManager 已经加载了文件，这里能读到真正的配置了
     PlcConfig plcConf = ConfigManager::instance().getPlcConfig();
@@ -148,10 +161,33 @@ MainWindow::MainWindow(QWidget *parent)
              << " IP:" << plcConf.ip
              << " Port:" << plcConf.port;
 
+    // [新增] 帧格式 (须与 PLC 以太网口的通信数据代码设置一致)
+    bool frameOk = false;
+    McFrameCodec::Mode frameMode = McFrameCodec::modeFromName(plcConf.frame, &frameOk);
+    if (!frameOk) {
+        qWarning() << "未知的 PLC 帧格式" << plcConf.frame << "，使用 ascii1e";
+    }
+    m_plc->setFrameMode(frameMode);
+
+    // [新增] 地址表：无效时不连 PLC，避免把结果写到错误的地址上
+    m_plcMap = plcConf.addressMap;
+    if (!m_plcMap.isValid()) {
+        qWarning() << "PLC 地址表无效:" << plcConf.addressMapError;
+        QMessageBox::critical(this, "PLC 地址表错误",
+                              QString("plc_automation.address_map 配置无效：\n%1\n\nPLC 通讯已禁用。")
+                              .arg(plcConf.addressMapError));
+        plcConf.enabled = false;
+    } else {
+        for (const QString &line : m_plcMap.describe()) qDebug() << line;
+        m_plc->setSignalAddresses(m_plcMap.startAddress(), m_plcMap.releaseAddress());
+        // 地址表工位多于界面上限时放开上限
+        if (m_plcMap.slotCount() > m_spinBoxCount->maximum()) m_spinBoxCount->setMaximum(m_plcMap.slotCount());
+    }
+
     // ============================================================
     // 【修复 5 - 核心】 必须调用 init 才能建立连接和启动轮询！
     // ============================================================
-    m_plc->init(plcConf.enabled, plcConf.ip, plcConf.port);
+    m_plc->init(plcConf.enabled, plcConf.ip, plcConf.port, plcConf.pipelineDepth, plcConf.responseTimeoutMs);
 
     // 更新初始灯光状态
     if(plcConf.enabled) {
@@ -206,10 +242,8 @@ void MainWindow::onChannelCountChanged(int count)
     if (count == 2) cols = 2;
 
     for(int i = 0; i < count; i++) {
-        DeviceChannelWidget *w = new DeviceChannelWidget(i + 1, this);
-
-        // [重要] 将 SN 管理器传给通道
-       // w->setSnManager(m_snManager);
+        // [重要] 各通道共用主窗口的 SN 管理器
+        DeviceChannelWidget *w = new DeviceChannelWidget(i + 1, m_snManager, this);
 
         // [新增] 连接身份上报信号 -> 主窗口的认领逻辑
         connect(w, &DeviceChannelWidget::identityReported,
@@ -248,6 +282,7 @@ void MainWindow::keyPressEvent(QKeyEvent *event) {
     // 2. 如果没匹配上 -> 加入缓存池
     if (!m_scanCache.contains(code)) {
         m_scanCache.append(code);
+        indexScanCode(code);
         qDebug() << ">>> [Scan Cache] Code added to pool:" << code;
 
         // 更新界面提示 (如果有 Label 的话)
@@ -259,13 +294,36 @@ void MainWindow::keyPressEvent(QKeyEvent *event) {
                          QString("扫描内容: [%1]\n未找到匹配的设备！").arg(code));
 }
 
+void MainWindow::indexScanCode(const QString &code)
+{
+    // 扫到的是白名单里的 SN：设备还没开机就能知道它应有的 IMSI
+    QString imsi;
+    if (m_snManager && m_snManager->findImsiBySn(code, imsi)) {
+        m_scanByImsi.insert(imsi, code);
+        qDebug() << ">>> [Cache] SN" << code << "-> expected IMSI" << imsi;
+    }
+}
+
 void MainWindow::onChannelIdentityReported(const QString &idValue)
 {
-    // 这里的 idValue 就是设备刚发上来的 IMEI
+    // 这里的 idValue 就是设备刚发上来的 IMEI 或 IMSI
     // sender() 是发出信号的那个通道对象
     DeviceChannelWidget* channel = qobject_cast<DeviceChannelWidget*>(sender());
     if (!channel) return;
 
+    // 0. 先按 IMSI 认领：缓存池里的 SN 标签已反查出期望 IMSI，哈希直接命中
+    auto hit = m_scanByImsi.find(idValue);
+    if (hit != m_scanByImsi.end()) {
+        QString matchedCode = hit.value();
+        m_scanByImsi.erase(hit);
+        m_scanCache.removeOne(matchedCode);
+
+        qDebug() << ">>> [Match] SN Hit! Channel" << channel->id() << "claimed code:" << matchedCode;
+        channel->setBarcode(matchedCode);
+        if(m_lblCacheStatus) m_lblCacheStatus->setText(QString("待匹配: %1").arg(m_scanCache.join(",")));
+        return;
+    }
+
     // 1. 去缓存池里找：有没有哪个码 等于 这个 IMEI？
     // (或者 contains，取决于您的码是不是完整的)
     int index = -1;
@@ -280,6 +338,13 @@ void MainWindow::onChannelIdentityReported(const QString &idValue)
     if (index != -1) {
         QString matchedCode = m_scanCache.takeAt(index); // 从池子里取出来，删掉
 
+        // 同一个码若也登记了期望 IMSI，一并删掉
+        QString imsi;
+        if (m_snManager && m_snManager->findImsiBySn(matchedCode, imsi)
+                && m_scanByImsi.value(imsi) == matchedCode) {
+            m_scanByImsi.remove(imsi);
+        }
+
         qDebug() << ">>> [Match] Cache Hit! Channel" << channel->id() << "claimed code:" << matchedCode;
 
         // 3. 填入通道
@@ -295,11 +360,11 @@ void MainWindow::onChannelIdentityReported(const QString &idValue)
 // 在 MainWindow.cpp 中，替换原有的扫码逻辑
 void MainWindow::onPlcStartSignal()
 {
-    qDebug() << ">>> [PLC] Start Signal (M1600) Received!";
+    qDebug() << ">>> [PLC] Start Signal Received!";
 
-    // 1. 【握手复位】 立即将 M1600 写回 0 (防止信号一直置位)
+    // 1. 【握手复位】 立即将启动信号 (默认 M1600) 写回 0 (防止信号一直置位)
     if (m_plc) {
-        m_plc->writeDevice(1600, false);
+        m_plc->writeDevice(m_plcMap.startAddress(), false);
     }
 
     appendToLog(">>> [PLC] 收到启动信号，正在等待条码文件(SN.txt)...");
@@ -505,11 +570,16 @@ void MainWindow::finalizePlcResult()
 {
     if (!m_plc) return;
 
-    appendToLog(">>> [结算] 所有通道处理完毕，开始分步上报 PLC...");
+    appendToLog(">>> [结算] 所有通道处理完毕，批量上报 PLC...");
 
     bool hasGlobalImeiError = false;
+    QVector<bool> results;
 
-    // --- 第一阶段：写入各通道结果 (M1655/M1660) ---
+    // --- 第一阶段：各通道结果与报警按地址表编成块写入 (默认 M1655/M1660/M1665 合成一帧) ---
+    if (m_plcMap.isValid() && m_channels.size() > m_plcMap.slotCount()) {
+        appendToLog(QString(">>> [结算] 警告: 通道数 %1 超出 PLC 地址表的 %2 个工位，多出的通道不上报")
+                    .arg(m_channels.size()).arg(m_plcMap.slotCount()));
+    }
     for (int i = 0; i < m_channels.size(); ++i) {
         DeviceChannelWidget* ch = m_channels[i];
         if (!ch) continue;
@@ -521,39 +591,62 @@ void MainWindow::finalizePlcResult()
         if (ch->getFailureReason() == Reason_IMEI) {
             hasGlobalImeiError = true;
         }
-
-        int addrOk = 1655 + i; // M1655+
-        int addrNg = 1660 + i; // M1660+
-
-        if (isPass) {
-            m_plc->writeDevice(addrOk, true);  // 写 OK
-            m_plc->writeDevice(addrNg, false); // 清 NG
-        } else {
-            m_plc->writeDevice(addrOk, false); // 清 OK
-            m_plc->writeDevice(addrNg, true);  // 写 NG
+        else if (ch->getFailureReason() == Reason_NoSignal) {
+            appendToLog(QString(">>> [结算] 通道 %1 无信号 (空工位/未上电)，按 NG 上报").arg(ch->id()));
         }
+
+        // PASS: 写 OK 清 NG；FAIL: 清 OK 写 NG (见 PlcAddressMap::encodeResults)
+        results.append(isPass);
     }
 
-    // 处理严重报警 M1665
-    m_plc->writeDevice(1665, hasGlobalImeiError);
+    // 处理严重报警 (默认 M1665)
     if (hasGlobalImeiError) {
-        appendToLog(">>> [PLC] 严重报警: 检测到 IMEI 混料 (M1665 ON)");
+        appendToLog(">>> [PLC] 严重报警: 检测到 IMEI 混料 (报警位 ON)");
     }
 
-    // --- 第二阶段：延时 200ms 后再写入放行信号 (M1650) ---
-    // 增加物理延时，确保 PLC 扫描周期能捕捉到前面的状态切换
-    QTimer::singleShot(200, this, [this](){
-        if (m_plc) {
-            appendToLog(">>> [PLC] 状态已稳定，发送流程结束信号 (M1650 ON)");
-            m_plc->writeDevice(1650, true);
-        }
+    // --- 第二阶段：PLC 应答确认结果已写入后，再写放行信号 (默认 M1650) ---
+    // 见 onPlcBatchWritten；PLC 未启用时没有应答，直接收尾
+    m_resultBatchId = m_plc->writeBlocks(m_plcMap.encodeResults(results, hasGlobalImeiError));
+    if (m_resultBatchId == 0) finishPlcCycle();
+}
 
-        // 状态复位显示
+// [新增] 结果批次的应答
+void MainWindow::onPlcBatchWritten(int batchId, bool ok)
+{
+    if (batchId != m_resultBatchId) return;
+    m_resultBatchId = 0;
+
+    if (!ok) {
+        // 结果没写进 PLC 就放行会让 PLC 按旧结果分拣，宁可停线等人处理
+        appendToLog(QString(">>> [PLC] 错误: 结果上报未得到确认，未发送放行信号 (M%1)，请检查 PLC 连接")
+                    .arg(m_plcMap.releaseAddress()));
         if(m_lblCacheStatus) {
-            m_lblCacheStatus->setText("状态: 等待下一轮启动");
-            m_lblCacheStatus->setStyleSheet("color: black;");
+            m_lblCacheStatus->setText("状态: PLC 结果上报失败");
+            m_lblCacheStatus->setStyleSheet("color: red; font-weight: bold;");
         }
-    });
+        return;
+    }
+
+    appendToLog(QString(">>> [PLC] 结果已确认写入 (往返 %1 ms)，发送流程结束信号 (M%2 ON)")
+                .arg(m_plc->linkStats().lastRttMs, 0, 'f', 1).arg(m_plcMap.releaseAddress()));
+    m_plc->writeDevice(m_plcMap.releaseAddress(), true);
+    finishPlcCycle();
+}
+
+// 本轮收尾：复位状态显示，空闲时合并台账
+void MainWindow::finishPlcCycle()
+{
+    // 状态复位显示
+    if(m_lblCacheStatus) {
+        m_lblCacheStatus->setText("状态: 等待下一轮启动");
+        m_lblCacheStatus->setStyleSheet("color: black;");
+    }
+
+    // 周期间隙合并身份台账 (后台执行，合并期间查重会短暂等待)
+    if (IdentityLedger::instance().needsCompaction()) {
+        appendToLog(">>> [台账] 追加日志已满，后台合并快照");
+        QtConcurrent::run([]() { IdentityLedger::instance().compact(); });
+    }
 }
 
 // 更新状态灯
@@ -609,6 +702,7 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
                 if (!matched) {
                     if (!m_scanCache.contains(code)) {
                         m_scanCache.append(code);
+                        indexScanCode(code);
                         qDebug() << ">>> [Cache] Code added to pool:" << code;
 
                         // [可选] 如果您加了显示 Label，在这里更新
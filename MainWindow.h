@@ -9,6 +9,7 @@
 #include <QToolBar>
 #include <QMessageBox>
 #include <QKeyEvent>
+#include <QHash>
 #include "DeviceChannelWidget.h" // 引用你的通道组件头文件
 #include "SnManager.h"
 #include "PlcController.h"
@@ -32,6 +33,7 @@ private slots:
     void onChannelCountChanged(int count);
     void onPlcStartSignal();
     void onPlcStopSignal(); // [新增]
+    void onPlcBatchWritten(int batchId, bool ok); // [新增] 结果批次应答
     // 测试结果槽 [修改签名]
     void onChannelTestFinished(int channelId, bool isPass, int failureReason);
     // [新增] 处理通道上报的身份信息
@@ -60,8 +62,13 @@ private:
     // [新增] 扫码缓存池 (暂存还没有对应串口数据的条码)
     QStringList m_scanCache;
 
+    // [新增] 缓存池里能反查到 IMSI 的 SN 标签：期望 IMSI -> 条码 (设备上报 IMSI 时 O(1) 认领)
+    QHash<QString, QString> m_scanByImsi;
+
     // [新增] 核心控制器
     PlcController *m_plc;
+    // [新增] PLC 地址表 (启动/放行/OK/NG/报警)
+    PlcAddressMap m_plcMap;
     SnManager *m_snManager;
 
     // [新增] PLC 状态指示灯
@@ -81,8 +88,15 @@ private:
     void distributeBarcodeAndStart(const QString &rawContent);
 
     void finalizePlcResult();
+    void finishPlcCycle();
     void checkBarcodeTimeout();
 
+    // [新增] 扫到的条码进缓存池时，按 SN 反查期望 IMSI
+    void indexScanCode(const QString &code);
+
+    // [新增] 本轮结果批量写入的批次号 (0 = 没有在等应答)
+    int m_resultBatchId = 0;
+
     // [新增] 重试计数器
     int m_retryCount = 0;
     const int MAX_RETRIES = 3; // 最大重试次数
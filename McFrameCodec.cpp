@@ -0,0 +1,312 @@
+#include "McFrameCodec.h"
+
+namespace {
+const int kTimer = 10;                  // 监视定时器 (单位 250ms)
+const quint16 kDeviceM1E = 0x4D20;      // 1E 帧设备代码: M
+const quint8 kDeviceM3E = 0x90;         // 3E 帧设备代码: M
+const quint16 kDeviceD1E = 0x4420;      // 1E 帧设备代码: D
+const quint8 kDeviceD3E = 0xA8;         // 3E 帧设备代码: D
+
+// 下标与 McFrameCodec::Command 对应
+const quint8 k1ECommand[] = { 0x00, 0x02, 0x03 };   // 成批读 / 成批写 (位)，成批写 (字)
+const quint16 k3ECommand[] = { 0x0401, 0x1401, 0x1401 };
+const quint16 k3ESubBits = 0x0001;      // 子指令: 以位为单位
+const quint16 k3ESubWords = 0x0000;     // 子指令: 以字为单位
+
+// 3E 帧头: 副头部(2) 网络号(1) PLC号(1) 模块IO号(2) 站号(1) 数据长度(2)
+const int k3EHeaderSize = 9;
+const int k3ELengthOffset = 7;
+
+const char kHex[] = "0123456789ABCDEF";
+
+inline void putHex(QByteArray &out, quint32 v, int digits)
+{
+    for (int i = digits - 1; i >= 0; --i) out.append(kHex[(v >> (i * 4)) & 0xF]);
+}
+
+inline void putLe(QByteArray &out, quint32 v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) out.append(char((v >> (i * 8)) & 0xFF));
+}
+
+inline int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// 定长十六进制字段，非法字符返回 -1
+inline int readHex(const char *p, int digits)
+{
+    int v = 0;
+    for (int i = 0; i < digits; ++i) {
+        int d = hexDigit(p[i]);
+        if (d < 0) return -1;
+        v = (v << 4) | d;
+    }
+    return v;
+}
+
+inline quint16 le16(const char *p)
+{
+    return quint16(quint8(p[0]) | (quint8(p[1]) << 8));
+}
+
+// 二进制位数据: 每字节 2 点，高 4 位在前
+inline void putPackedBits(QByteArray &out, const QVector<WriteTask> &points)
+{
+    for (int i = 0; i < points.size(); i += 2) {
+        quint8 b = quint8(points.at(i).value ? 0x10 : 0x00);
+        if (i + 1 < points.size() && points.at(i + 1).value) b |= 0x01;
+        out.append(char(b));
+    }
+}
+
+inline void readPackedBits(const char *p, int count, McReply *reply)
+{
+    reply->bits.resize(count);
+    for (int i = 0; i < count; ++i) {
+        quint8 b = quint8(p[i / 2]);
+        reply->bits[i] = ((i & 1) ? (b & 0x0F) : (b >> 4)) != 0;
+    }
+}
+}
+
+McFrameCodec::Mode McFrameCodec::modeFromName(const QString &name, bool *ok)
+{
+    QString n = name.trimmed().toLower();
+    if (ok) *ok = true;
+    if (n == "ascii1e") return Ascii1E;
+    if (n == "binary1e") return Binary1E;
+    if (n == "binary3e") return Binary3E;
+    if (ok) *ok = false;
+    return Ascii1E;
+}
+
+QString McFrameCodec::modeName(Mode mode)
+{
+    switch (mode) {
+    case Binary1E: return "binary1e";
+    case Binary3E: return "binary3e";
+    default: return "ascii1e";
+    }
+}
+
+int McFrameCodec::maxPoints(Command cmd) const
+{
+    if (m_mode == Binary3E) return cmd == WriteWords ? 960 : 3584;
+    return cmd == WriteWords ? 64 : 256;
+}
+
+// -----------------------------------------------------------
+// 编码
+// -----------------------------------------------------------
+void McFrameCodec::beginFrame(QByteArray &out, Command cmd) const
+{
+    switch (m_mode) {
+    case Ascii1E:
+        putHex(out, k1ECommand[cmd], 2);
+        out.append("FF", 2);
+        putHex(out, kTimer, 4);
+        break;
+    case Binary1E:
+        out.append(char(k1ECommand[cmd]));
+        out.append(char(0xFF));
+        putLe(out, kTimer, 2);
+        break;
+    case Binary3E:
+        out.append(char(0x50));
+        out.append(char(0x00));
+        out.append(char(0x00));         // 网络号
+        out.append(char(0xFF));         // PLC 号
+        putLe(out, 0x03FF, 2);          // 请求目标模块 IO 号
+        out.append(char(0x00));         // 请求目标模块站号
+        putLe(out, 0, 2);               // 数据长度，endFrame 回填
+        putLe(out, kTimer, 2);
+        putLe(out, k3ECommand[cmd], 2);
+        putLe(out, cmd == WriteWords ? k3ESubWords : k3ESubBits, 2);
+        break;
+    }
+}
+
+void McFrameCodec::endFrame(QByteArray &out, int start) const
+{
+    if (m_mode != Binary3E) return;
+    // 数据长度 = 监视定时器起到帧尾的字节数
+    int length = out.size() - start - k3EHeaderSize;
+    out[start + k3ELengthOffset] = char(length & 0xFF);
+    out[start + k3ELengthOffset + 1] = char((length >> 8) & 0xFF);
+}
+
+void McFrameCodec::encodeReadBits(QByteArray &out, int address, int count) const
+{
+    int start = out.size();
+    beginFrame(out, ReadBits);
+    switch (m_mode) {
+    case Ascii1E:
+        putHex(out, kDeviceM1E, 4);
+        putHex(out, quint32(address), 8);
+        putHex(out, quint32(count) & 0xFF, 2);
+        out.append("00", 2);
+        break;
+    case Binary1E:
+        putLe(out, quint32(address), 4);
+        putLe(out, kDeviceM1E, 2);
+        out.append(char(count & 0xFF));
+        out.append(char(0x00));
+        break;
+    case Binary3E:
+        putLe(out, quint32(address), 3);
+        out.append(char(kDeviceM3E));
+        putLe(out, quint32(count), 2);
+        break;
+    }
+    endFrame(out, start);
+}
+
+void McFrameCodec::encodeWriteBits(QByteArray &out, const QVector<WriteTask> &points) const
+{
+    int start = out.size();
+    int address = points.first().address;
+    int count = points.size();
+    beginFrame(out, WriteBits);
+    switch (m_mode) {
+    case Ascii1E:
+        putHex(out, kDeviceM1E, 4);
+        putHex(out, quint32(address), 8);
+        putHex(out, quint32(count) & 0xFF, 2);
+        out.append("00", 2);
+        for (const WriteTask &p : points) out.append(p.value ? '1' : '0');
+        break;
+    case Binary1E:
+        putLe(out, quint32(address), 4);
+        putLe(out, kDeviceM1E, 2);
+        out.append(char(count & 0xFF));
+        out.append(char(0x00));
+        putPackedBits(out, points);
+        break;
+    case Binary3E:
+        putLe(out, quint32(address), 3);
+        out.append(char(kDeviceM3E));
+        putLe(out, quint32(count), 2);
+        putPackedBits(out, points);
+        break;
+    }
+    endFrame(out, start);
+}
+
+void McFrameCodec::encodeWriteWords(QByteArray &out, int address, const QVector<quint16> &words) const
+{
+    int start = out.size();
+    int count = words.size();
+    beginFrame(out, WriteWords);
+    switch (m_mode) {
+    case Ascii1E:
+        putHex(out, kDeviceD1E, 4);
+        putHex(out, quint32(address), 8);
+        putHex(out, quint32(count) & 0xFF, 2);
+        out.append("00", 2);
+        for (quint16 w : words) putHex(out, w, 4);
+        break;
+    case Binary1E:
+        putLe(out, quint32(address), 4);
+        putLe(out, kDeviceD1E, 2);
+        out.append(char(count & 0xFF));
+        out.append(char(0x00));
+        for (quint16 w : words) putLe(out, w, 2);
+        break;
+    case Binary3E:
+        putLe(out, quint32(address), 3);
+        out.append(char(kDeviceD3E));
+        putLe(out, quint32(count), 2);
+        for (quint16 w : words) putLe(out, w, 2);
+        break;
+    }
+    endFrame(out, start);
+}
+
+// -----------------------------------------------------------
+// 解码
+// -----------------------------------------------------------
+int McFrameCodec::decode(const char *buf, int len, Command cmd, int readPoints, McReply *reply) const
+{
+    if (cmd != ReadBits) readPoints = 0;
+    switch (m_mode) {
+    case Binary1E: return decodeBinary1E(buf, len, cmd, readPoints, reply);
+    case Binary3E: return decodeBinary3E(buf, len, cmd, readPoints, reply);
+    default: return decodeAscii1E(buf, len, cmd, readPoints, reply);
+    }
+}
+
+// 副头部(2) 结束代码(2) [读: 每点 1 字符 | 5B: 异常代码(2)]
+int McFrameCodec::decodeAscii1E(const char *buf, int len, Command cmd, int readPoints, McReply *reply) const
+{
+    // 跳过应答之间的填充 (奇数点读的补位 '0'、部分模块带的回车换行)
+    int skip = 0;
+    while (skip < len) {
+        char c = buf[skip];
+        if (c != '0' && c != '\r' && c != '\n' && c != ' ') break;
+        skip++;
+    }
+    const char *p = buf + skip;
+    int n = len - skip;
+    if (n < 4) return 0;
+
+    if (readHex(p, 2) != (k1ECommand[cmd] | 0x80)) return -1;
+    int end = readHex(p + 2, 2);
+    if (end < 0) return -1;
+
+    int length = 4;
+    if (end == 0) length += readPoints;
+    else if (end == 0x5B) length += 2;
+    if (n < length) return 0;
+
+    reply->endCode = end;
+    reply->abnormalCode = end == 0x5B ? qMax(0, readHex(p + 4, 2)) : 0;
+    reply->bits.resize(end == 0 ? readPoints : 0);
+    for (int i = 0; i < reply->bits.size(); ++i) reply->bits[i] = p[4 + i] == '1';
+    return skip + length;
+}
+
+// 副头部(1) 结束代码(1) [读: 每字节 2 点 | 5B: 异常代码(1)]
+int McFrameCodec::decodeBinary1E(const char *buf, int len, Command cmd, int readPoints, McReply *reply) const
+{
+    if (len < 2) return 0;
+    if (quint8(buf[0]) != (k1ECommand[cmd] | 0x80)) return -1;
+
+    int end = quint8(buf[1]);
+    int length = 2;
+    if (end == 0) length += (readPoints + 1) / 2;
+    else if (end == 0x5B) length += 1;
+    if (len < length) return 0;
+
+    reply->endCode = end;
+    reply->abnormalCode = end == 0x5B ? quint8(buf[2]) : 0;
+    if (end == 0) readPackedBits(buf + 2, readPoints, reply);
+    else reply->bits.resize(0);
+    return length;
+}
+
+// 副头部 D0 00 (2) 网络号 PLC号 模块IO号 站号 (5) 数据长度(2) 结束代码(2) 数据
+int McFrameCodec::decodeBinary3E(const char *buf, int len, Command cmd, int readPoints, McReply *reply) const
+{
+    Q_UNUSED(cmd);
+    if (len < k3EHeaderSize + 2) return 0;
+    if (quint8(buf[0]) != 0xD0 || quint8(buf[1]) != 0x00) return -1;
+
+    int dataLength = le16(buf + k3ELengthOffset);
+    if (dataLength < 2) return -1;
+    int length = k3EHeaderSize + dataLength;
+    if (len < length) return 0;
+
+    int end = le16(buf + k3EHeaderSize);
+    if (end == 0 && dataLength - 2 < (readPoints + 1) / 2) return -1;
+
+    reply->endCode = end;
+    reply->abnormalCode = 0;
+    if (end == 0) readPackedBits(buf + k3EHeaderSize + 2, readPoints, reply);
+    else reply->bits.resize(0);
+    return length;
+}
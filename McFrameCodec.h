@@ -0,0 +1,82 @@
+#ifndef MCFRAMECODEC_H
+#define MCFRAMECODEC_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QVarLengthArray>
+
+// 写入指令结构体 (一个 M 位)
+struct WriteTask {
+    int address;
+    bool value;
+};
+
+// 解码出的一条应答
+struct McReply {
+    int endCode = 0;                    // 0 为正常
+    int abnormalCode = 0;               // 1E 结束代码 5B 之后的异常代码
+    QVarLengthArray<bool, 64> bits;     // 读位应答的各点状态
+};
+
+// 一段连续地址的写入 (一帧)：M 位或 D 字
+struct WriteBlock {
+    enum Device { M, D };
+    Device device = M;
+    int address = 0;
+    QVector<quint16> values;            // M: 每点 0/1；D: 每个字
+};
+
+/**
+ * @brief 三菱 MC 协议帧编解码 (只涉及本程序用到的 M 位读写)
+ * * 三种帧格式：
+ *   Ascii1E  A 兼容 1E 帧 ASCII 码 (原有格式，保留作兼容)
+ *   Binary1E A 兼容 1E 帧二进制码
+ *   Binary3E QnA 兼容 3E 帧二进制码 (Q/L/iQ-R 内置以太网口)
+ * * 编码写入调用方复用的缓冲区 (先 reserve，resize(0) 后追加，不反复分配)；
+ *   二进制帧按固定偏移填字段，不经过 QString。
+ * * 解码直接在接收缓冲上按固定偏移取字段，返回本条应答占用的字节数，
+ *   供调用方做流式切帧：>0 完整一条，0 还不够一条，<0 与请求不符。
+ * * 除 M 位外只支持 D 寄存器成批写 (按字)，用于把多个工位的结果压成字一次写入。
+ * * 1E/3E 帧都没有序号，应答与请求的对应由调用方按发送顺序保证。
+ */
+class McFrameCodec
+{
+public:
+    enum Mode { Ascii1E, Binary1E, Binary3E };
+    enum Command { ReadBits, WriteBits, WriteWords };
+
+    explicit McFrameCodec(Mode mode = Ascii1E) : m_mode(mode) {}
+
+    Mode mode() const { return m_mode; }
+    // 配置里的名字 "ascii1e" / "binary1e" / "binary3e"
+    static Mode modeFromName(const QString &name, bool *ok = nullptr);
+    static QString modeName(Mode mode);
+
+    // 单帧最多点数
+    int maxPoints(Command cmd) const;
+
+    // --- 编码 (追加到 out 末尾) ---
+    void encodeReadBits(QByteArray &out, int address, int count) const;
+    // points 须按地址连续排列
+    void encodeWriteBits(QByteArray &out, const QVector<WriteTask> &points) const;
+    // D 寄存器成批写
+    void encodeWriteWords(QByteArray &out, int address, const QVector<quint16> &words) const;
+
+    // --- 解码 ---
+    // readPoints: 对应请求为 ReadBits 时的点数 (决定应答数据长度)
+    int decode(const char *buf, int len, Command cmd, int readPoints, McReply *reply) const;
+
+private:
+    int decodeAscii1E(const char *buf, int len, Command cmd, int readPoints, McReply *reply) const;
+    int decodeBinary1E(const char *buf, int len, Command cmd, int readPoints, McReply *reply) const;
+    int decodeBinary3E(const char *buf, int len, Command cmd, int readPoints, McReply *reply) const;
+
+    void beginFrame(QByteArray &out, Command cmd) const;
+    void endFrame(QByteArray &out, int start) const;
+
+private:
+    Mode m_mode;
+};
+
+#endif // MCFRAMECODEC_H
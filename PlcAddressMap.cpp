@@ -0,0 +1,198 @@
+#include "PlcAddressMap.h"
+#include <algorithm>
+
+namespace {
+const int kMaxSlots = 64;
+const int kMaxAddress = 0xFFFFFF;   // 3E 帧地址字段为 3 字节
+const int kWordBits = 16;
+
+// "M1655" / "D100"；纯数字按 M 处理
+bool parseDevice(const QJsonValue &v, WriteBlock::Device *device, int *address)
+{
+    bool ok = false;
+    if (v.isDouble()) {
+        *device = WriteBlock::M;
+        *address = v.toInt(-1);
+        ok = true;
+    } else {
+        QString text = v.toString().trimmed().toUpper();
+        if (text.isEmpty()) return false;
+        QChar prefix = text.at(0);
+        if (prefix == 'M') *device = WriteBlock::M;
+        else if (prefix == 'D') *device = WriteBlock::D;
+        else return false;
+        *address = text.mid(1).toInt(&ok);
+    }
+    return ok && *address >= 0 && *address <= kMaxAddress;
+}
+}
+
+PlcAddressMap PlcAddressMap::legacy()
+{
+    QJsonObject obj;
+    obj["slots"] = 5;
+    obj["start"] = "M1600";
+    obj["release"] = "M1650";
+    obj["ok"] = "M1655";
+    obj["ng"] = "M1660";
+    obj["alarm"] = "M1665";
+    QString error;
+    return compile(obj, &error);
+}
+
+PlcAddressMap PlcAddressMap::compile(const QJsonObject &obj, QString *error)
+{
+    PlcAddressMap map;
+    int slotCount = obj.value("slots").toInt(5);
+    if (slotCount < 1 || slotCount > kMaxSlots) {
+        if (error) *error = QString("slots 须在 1~%1 之间 (当前 %2)").arg(kMaxSlots).arg(slotCount);
+        return map;
+    }
+
+    // 缺省的字段沿用原有地址
+    const struct { Signal signal; const char *key; const char *def; } fields[] = {
+        { Start, "start", "M1600" }, { Release, "release", "M1650" },
+        { Ok, "ok", "M1655" }, { Ng, "ng", "M1660" }, { Alarm, "alarm", "M1665" },
+    };
+
+    QVector<Range> ranges;
+    for (const auto &f : fields) {
+        Range r;
+        r.signal = f.signal;
+        QJsonValue v = obj.contains(f.key) ? obj.value(f.key) : QJsonValue(QString(f.def));
+        if (!parseDevice(v, &r.device, &r.address)) {
+            if (error) *error = QString("%1 地址无法识别: %2").arg(f.key).arg(v.toVariant().toString());
+            return map;
+        }
+        if ((f.signal == Start || f.signal == Release) && r.device != WriteBlock::M) {
+            if (error) *error = QString("%1 须为 M 位").arg(f.key);
+            return map;
+        }
+
+        if (f.signal == Ok || f.signal == Ng) {
+            r.count = r.device == WriteBlock::M ? slotCount : (slotCount + kWordBits - 1) / kWordBits;
+        } else {
+            r.count = 1;
+        }
+        if (r.address + r.count - 1 > kMaxAddress) {
+            if (error) *error = QString("%1 地址超出范围").arg(rangeText(r));
+            return map;
+        }
+        ranges.append(r);
+    }
+
+    map.m_slotCount = slotCount;
+    map.m_start = ranges.at(0).address;
+    map.m_release = ranges.at(1).address;
+    if (!map.build(ranges, error)) map.m_slotCount = 0;
+    return map;
+}
+
+// 检查重叠，再把结果信号 (OK/NG/报警) 按设备、地址排序，首尾相接的合并成一块
+bool PlcAddressMap::build(const QVector<Range> &ranges, QString *error)
+{
+    for (int i = 0; i < ranges.size(); ++i) {
+        for (int j = i + 1; j < ranges.size(); ++j) {
+            const Range &a = ranges.at(i);
+            const Range &b = ranges.at(j);
+            if (a.device != b.device) continue;
+            if (a.address < b.address + b.count && b.address < a.address + a.count) {
+                if (error) *error = QString("%1 (%2) 与 %3 (%4) 地址重叠")
+                        .arg(signalName(a.signal)).arg(rangeText(a))
+                        .arg(signalName(b.signal)).arg(rangeText(b));
+                return false;
+            }
+        }
+    }
+
+    QVector<Range> results;
+    for (const Range &r : ranges) {
+        if (r.signal != Start && r.signal != Release) results.append(r);
+    }
+    std::sort(results.begin(), results.end(), [](const Range &a, const Range &b) {
+        return a.device != b.device ? a.device < b.device : a.address < b.address;
+    });
+
+    m_blocks.clear();
+    for (const Range &r : results) {
+        if (!m_blocks.isEmpty()) {
+            Block &last = m_blocks.last();
+            if (last.device == r.device && last.address + last.count == r.address) {
+                last.count += r.count;
+                last.ranges.append(r);
+                continue;
+            }
+        }
+        Block block;
+        block.device = r.device;
+        block.address = r.address;
+        block.count = r.count;
+        block.ranges.append(r);
+        m_blocks.append(block);
+    }
+    return true;
+}
+
+QVector<WriteBlock> PlcAddressMap::encodeResults(const QVector<bool> &pass, bool alarm) const
+{
+    int n = qMin(pass.size(), m_slotCount);
+    QVector<WriteBlock> out;
+    out.reserve(m_blocks.size());
+
+    for (const Block &block : m_blocks) {
+        WriteBlock wb;
+        wb.device = block.device;
+        wb.address = block.address;
+        wb.values.fill(0, block.count);
+        quint16 *values = wb.values.data();
+
+        for (const Range &r : block.ranges) {
+            int offset = r.address - block.address;
+            if (r.signal == Alarm) {
+                values[offset] = alarm ? 1 : 0;
+                continue;
+            }
+            // PASS: 置 OK 清 NG；FAIL: 清 OK 置 NG
+            bool wantPass = r.signal == Ok;
+            for (int i = 0; i < n; ++i) {
+                if (pass.at(i) != wantPass) continue;
+                if (r.device == WriteBlock::M) values[offset + i] = 1;
+                else values[offset + i / kWordBits] |= quint16(1u << (i % kWordBits));
+            }
+        }
+        out.append(wb);
+    }
+    return out;
+}
+
+QStringList PlcAddressMap::describe() const
+{
+    QStringList lines;
+    lines << QString("PLC 地址表: %1 个工位，启动 M%2，放行 M%3")
+             .arg(m_slotCount).arg(m_start).arg(m_release);
+    for (const Block &block : m_blocks) {
+        QStringList parts;
+        for (const Range &r : block.ranges) parts << QString("%1 %2").arg(signalName(r.signal)).arg(rangeText(r));
+        Range whole = { Ok, block.device, block.address, block.count };
+        lines << QString("  结果帧 %1: %2").arg(rangeText(whole)).arg(parts.join(", "));
+    }
+    return lines;
+}
+
+QString PlcAddressMap::signalName(Signal signal)
+{
+    switch (signal) {
+    case Start: return "启动";
+    case Release: return "放行";
+    case Ok: return "OK";
+    case Ng: return "NG";
+    default: return "报警";
+    }
+}
+
+QString PlcAddressMap::rangeText(const Range &r)
+{
+    QString dev = r.device == WriteBlock::M ? "M" : "D";
+    if (r.count == 1) return dev + QString::number(r.address);
+    return QString("%1%2~%1%3").arg(dev).arg(r.address).arg(r.address + r.count - 1);
+}
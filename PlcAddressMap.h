@@ -0,0 +1,66 @@
+#ifndef PLCADDRESSMAP_H
+#define PLCADDRESSMAP_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "McFrameCodec.h"   // WriteBlock
+
+/**
+ * @brief PLC 地址表 (plc_automation.address_map)
+ * * 启动/放行为 M 位；OK、NG、报警可以放在 M 位，也可以放在 D 寄存器：
+ *   M  每个工位占 1 位，slots 个工位占连续 slots 位
+ *   D  工位 i 为第 i/16 个字的 bit (i%16)，16 个工位占 1 个字；报警占 1 个字 (0/1)
+ * * 加载时编译一次：检查各信号的地址范围互不重叠，再把同一设备上首尾相接的
+ *   信号合并成块。每块一帧，上报一轮结果的帧数只取决于地址表，与工位数无关。
+ * * 不配置 address_map 时为原有的硬编码地址 (5 个工位)，上报仍是一帧 11 位的成批写。
+ */
+class PlcAddressMap
+{
+public:
+    enum Signal { Start, Release, Ok, Ng, Alarm };
+
+    // 原有地址：启动 M1600，放行 M1650，OK M1655+，NG M1660+，报警 M1665
+    static PlcAddressMap legacy();
+    // 出错时返回的地址表 isValid() 为 false，error 说明原因
+    static PlcAddressMap compile(const QJsonObject &obj, QString *error);
+
+    bool isValid() const { return m_slotCount > 0; }
+    int slotCount() const { return m_slotCount; }
+    int startAddress() const { return m_start; }
+    int releaseAddress() const { return m_release; }
+
+    // 一轮结果编成写入块；pass 按工位顺序，超出 slots 的忽略，不足的工位 OK/NG 都清 0
+    QVector<WriteBlock> encodeResults(const QVector<bool> &pass, bool alarm) const;
+
+    // 日志用：各信号地址与合并后的块
+    QStringList describe() const;
+
+private:
+    struct Range {
+        Signal signal;
+        WriteBlock::Device device;
+        int address;
+        int count;
+    };
+
+    struct Block {
+        WriteBlock::Device device;
+        int address;
+        int count;
+        QVector<Range> ranges;
+    };
+
+    static QString signalName(Signal signal);
+    static QString rangeText(const Range &r);
+    bool build(const QVector<Range> &results, QString *error);
+
+private:
+    int m_slotCount = 0;
+    int m_start = 0;
+    int m_release = 0;
+    QVector<Block> m_blocks;
+};
+
+#endif // PLCADDRESSMAP_H
@@ -1,6 +1,11 @@
 #include "PlcController.h"
 #include <QDebug>
 
+namespace {
+const int kMaxWriteAttempts = 3;    // 写入最多发送次数 (含首次)
+const int kFrameReserve = 1024;     // 编码缓冲预分配 (结果块、轮询帧都放得下)
+}
+
 PlcController::PlcController(QObject *parent) : QObject(parent)
 {
     m_isEnabled = false;
@@ -8,15 +13,23 @@ PlcController::PlcController(QObject *parent) : QObject(parent)
     m_port = 0;
     m_lastStartSignalVal = -1;
     m_pollStep = 0;
+    m_startAddress = 1600;
+    m_releaseAddress = 1650;
     m_ignoreStopSignalUntil = 0; // [新增] 初始化
 
     m_socket = new QTcpSocket(this);
     m_pollTimer = new QTimer(this);
 
-    // [新增] 初始化写入队列定时器，间隔 50ms 防止粘包
-    m_writeTimer = new QTimer(this);
-    m_writeTimer->setInterval(50);
-    connect(m_writeTimer, &QTimer::timeout, this, &PlcController::processWriteQueue);
+    // [新增] 请求队列：在途请求数由 pipelineDepth 限制，不再靠 50ms 间隔防止粘包
+    m_pipelineDepth = 4;
+    m_responseTimeoutMs = 3000;
+    m_pollPending = false;
+    m_nextBatchId = 1;
+    m_clock.start();
+    m_txFrame.reserve(kFrameReserve);
+    m_requestTimer = new QTimer(this);
+    m_requestTimer->setSingleShot(true);
+    connect(m_requestTimer, &QTimer::timeout, this, &PlcController::onRequestTimeout);
 
     // 连接 Socket 信号
     connect(m_socket, &QTcpSocket::connected, this, &PlcController::onSocketConnected);
@@ -34,11 +47,13 @@ PlcController::~PlcController()
     disconnectPlc();
 }
 
-void PlcController::init(bool enabled, const QString &ip, int port)
+void PlcController::init(bool enabled, const QString &ip, int port, int pipelineDepth, int responseTimeoutMs)
 {
     m_isEnabled = enabled;
     m_ip = ip;
     m_port = port;
+    m_pipelineDepth = qMax(1, pipelineDepth);
+    m_responseTimeoutMs = qMax(100, responseTimeoutMs);
 
     if (m_isEnabled) {
         // 如果已经连接或正在连接，先断开
@@ -68,39 +83,187 @@ void PlcController::writeDevice(int address, bool value)
 
     // [关键逻辑] 如果是写入 M1650=1 (测试完成)，则在未来 3秒内忽略 M1650 的读取
     // 防止 PLC 还没来得及复位，我们自己读回来导致误判为“强制停止”
-    if (address == 1650 && value) {
+    if (address == m_releaseAddress && value) {
         m_ignoreStopSignalUntil = QDateTime::currentMSecsSinceEpoch() + 3000;
-        qDebug() << "Writing M1650=1, ignoring Stop Signal for 3 seconds.";
+        qDebug() << "Writing release signal, ignoring Stop Signal for 3 seconds.";
     }
 
     // 加入队列
     WriteTask task;
     task.address = address;
     task.value = value;
-    m_writeQueue.enqueue(task);
+    PlcRequest req;
+    req.kind = PlcRequest::WriteBits;
+    req.frame.points.append(task);
+    enqueue(req);
+    pumpRequests();
+}
+
+void PlcController::setFrameMode(McFrameCodec::Mode mode)
+{
+    m_codec = McFrameCodec(mode);
+    m_rxBuffer.clear();
+    emit logMessage(QString("PLC 帧格式: %1").arg(McFrameCodec::modeName(mode)));
+}
+
+void PlcController::setSignalAddresses(int startAddress, int releaseAddress)
+{
+    m_startAddress = startAddress;
+    m_releaseAddress = releaseAddress;
+    m_lastStartSignalVal = -1;
+}
+
+int PlcController::nextBatchId()
+{
+    int id = m_nextBatchId++;
+    if (m_nextBatchId <= 0) m_nextBatchId = 1;
+    return id;
+}
+
+// [新增] 按块写入：地址表编译好的结果块，每块一帧，帧数与工位数无关
+int PlcController::writeBlocks(const QVector<WriteBlock> &blocks)
+{
+    if (!m_isEnabled || blocks.isEmpty()) return 0;
 
-    // 如果定时器没跑，就启动它
-    if (!m_writeTimer->isActive()) {
-        m_writeTimer->start();
+    for (const WriteBlock &b : blocks) {
+        McFrameCodec::Command cmd = b.device == WriteBlock::D ? McFrameCodec::WriteWords : McFrameCodec::WriteBits;
+        if (b.values.isEmpty() || b.values.size() > m_codec.maxPoints(cmd)) {
+            emit logMessage(QString("PLC 批量写入 %1%2 点数不合法 (%3)，已拒绝")
+                            .arg(b.device == WriteBlock::D ? "D" : "M").arg(b.address).arg(b.values.size()));
+            return 0;
+        }
     }
+
+    int batchId = nextBatchId();
+    m_batchFrames.insert(batchId, blocks.size());
+    for (const WriteBlock &b : blocks) {
+        PlcRequest req;
+        req.kind = PlcRequest::WriteBits;
+        req.frame.batchId = batchId;
+        if (b.device == WriteBlock::D) {
+            req.frame.wordAddress = b.address;
+            req.frame.words = b.values;
+        } else {
+            req.frame.points.reserve(b.values.size());
+            for (int i = 0; i < b.values.size(); ++i) req.frame.points.append({ b.address + i, b.values.at(i) != 0 });
+        }
+        enqueue(req);
+    }
+    pumpRequests();
+    return batchId;
+}
+
+PlcLinkStats PlcController::linkStats() const
+{
+    PlcLinkStats st = m_stats;
+    st.inFlight = m_inFlight.size();
+    st.queued = m_txQueue.size();
+    return st;
 }
 
 // -----------------------------------------------------------
-// 3. [新增] 队列处理函数
+// 3. [新增] 请求队列
 // -----------------------------------------------------------
-void PlcController::processWriteQueue()
+void PlcController::enqueue(const PlcRequest &req, bool front)
 {
-    if (m_writeQueue.isEmpty()) {
-        m_writeTimer->stop();
-        return;
+    if (front) m_txQueue.prepend(req);
+    else m_txQueue.enqueue(req);
+}
+
+// 在途请求不足 pipelineDepth 时把排队的请求发出去
+void PlcController::pumpRequests()
+{
+    if (m_socket->state() != QAbstractSocket::ConnectedState) return;
+
+    bool sent = false;
+    while (!m_txQueue.isEmpty() && m_inFlight.size() < m_pipelineDepth) {
+        PlcRequest req = m_txQueue.dequeue();
+        encodeRequest(req);
+        if (req.kind == PlcRequest::WriteBits) req.frame.attempts++;
+        req.sentNs = m_clock.nsecsElapsed();
+        m_socket->write(m_txFrame);
+        m_inFlight.enqueue(req);
+        sent = true;
     }
 
-    if (m_socket->state() == QAbstractSocket::ConnectedState) {
-        WriteTask task = m_writeQueue.dequeue();
-        QByteArray packet = buildWritePacket(task.address, task.value);
-        m_socket->write(packet);
+    if (sent) {
         // flush 确保立即发送，虽然 Qt socket 也是异步的，但这样更保险
         m_socket->flush();
+        if (!m_requestTimer->isActive()) armRequestTimer();
+    }
+}
+
+// 应答按顺序到达，只需盯住队首请求的期限
+void PlcController::armRequestTimer()
+{
+    if (m_inFlight.isEmpty()) {
+        m_requestTimer->stop();
+        return;
+    }
+    qint64 elapsedMs = (m_clock.nsecsElapsed() - m_inFlight.head().sentNs) / 1000000;
+    m_requestTimer->start(int(qMax<qint64>(0, m_responseTimeoutMs - elapsedMs)));
+}
+
+void PlcController::onRequestTimeout()
+{
+    if (m_inFlight.isEmpty()) return;
+
+    qint64 elapsedMs = (m_clock.nsecsElapsed() - m_inFlight.head().sentNs) / 1000000;
+    if (elapsedMs < m_responseTimeoutMs) {
+        armRequestTimer();
+        return;
+    }
+
+    m_stats.timeouts++;
+    failInFlight(QString("应答超时 (%1 ms)").arg(elapsedMs));
+    pumpRequests();
+}
+
+// 写入失败：还有重试次数就插回队首重发，否则放弃 (批量写入通知调用方)
+// 只负责排队，由调用方统一 pumpRequests，保证多帧插回时顺序不乱
+void PlcController::retryOrFail(WriteFrame frame, const QString &reason)
+{
+    QString what = frame.batchId ? QString("批量写入 #%1").arg(frame.batchId)
+                                 : QString("写入 M%1").arg(frame.points.first().address);
+    // 同批已有帧失败过：不再重发
+    if (frame.batchId && !m_batchFrames.contains(frame.batchId)) return;
+
+    if (frame.attempts < kMaxWriteAttempts) {
+        emit logMessage(QString("PLC %1 %2，第 %3 次重发").arg(what).arg(reason).arg(frame.attempts));
+        PlcRequest req;
+        req.kind = PlcRequest::WriteBits;
+        req.frame = frame;
+        enqueue(req, true);
+        return;
+    }
+
+    emit logMessage(QString("PLC %1 失败 (%2)").arg(what).arg(reason));
+    if (frame.batchId) {
+        // 同批排队未发的块作废：部分结果写进 PLC 也不会放行
+        m_batchFrames.remove(frame.batchId);
+        for (int i = m_txQueue.size() - 1; i >= 0; --i) {
+            if (m_txQueue.at(i).kind == PlcRequest::WriteBits && m_txQueue.at(i).frame.batchId == frame.batchId)
+                m_txQueue.removeAt(i);
+        }
+        emit errorOccurred(QString("PLC 批量写入失败: %1").arg(reason));
+        emit batchWritten(frame.batchId, false);
+    }
+}
+
+// 超时、断线或应答对不上：在途请求都得不到可信的应答了
+// 接收缓冲一并丢弃，重新从下一条请求开始对齐；读请求等下次轮询，写请求重发
+void PlcController::failInFlight(const QString &reason)
+{
+    m_requestTimer->stop();
+    m_rxBuffer.clear();
+    m_pollPending = false;
+
+    QQueue<PlcRequest> lost;
+    lost.swap(m_inFlight);
+
+    // 倒序插回队首，保持原来的发送顺序
+    for (int i = lost.size() - 1; i >= 0; --i) {
+        if (lost.at(i).kind == PlcRequest::WriteBits) retryOrFail(lost.at(i).frame, reason);
     }
 }
 
@@ -112,11 +275,20 @@ void PlcController::onSocketConnected()
     if (!m_pollTimer->isActive()) {
         m_pollTimer->start(200);
     }
+    // 断线期间排队的写入
+    pumpRequests();
 }
 
 void PlcController::onSocketDisconnected()
 {
     m_pollTimer->stop();
+    failInFlight("连接断开");
+
+    // 排队的轮询读作废，重连后重新轮询
+    for (int i = m_txQueue.size() - 1; i >= 0; --i) {
+        if (m_txQueue.at(i).kind == PlcRequest::ReadBits) m_txQueue.removeAt(i);
+    }
+
     emit plcDisconnected();
     emit logMessage("PLC 连接断开");
 
@@ -137,10 +309,47 @@ void PlcController::onSocketError(QAbstractSocket::SocketError socketError)
     // emit logMessage(QString("PLC 通信错误: %1").arg(m_socket->errorString()));
 }
 
+// [修改] TCP 不保证一次 readAll 正好是一条应答：可能只有半条，也可能几条粘在一起
+// 先攒进接收缓冲，按在途队首请求推算应答长度，凑满一条切一条
 void PlcController::onSocketReadyRead()
 {
-    QByteArray data = m_socket->readAll();
-    parseResponse(data);
+    m_rxBuffer += m_socket->readAll();
+
+    McReply reply;
+    int offset = 0;
+    while (!m_inFlight.isEmpty()) {
+        const PlcRequest &head = m_inFlight.head();
+        int length = m_codec.decode(m_rxBuffer.constData() + offset, m_rxBuffer.size() - offset,
+                                    head.command, head.count, &reply);
+        if (length == 0) break;     // 半条，等后续数据
+        if (length < 0) {
+            m_stats.resyncs++;
+            failInFlight(QString("应答 %1 与请求不符")
+                         .arg(QString::fromLatin1(m_rxBuffer.mid(offset, 4).toHex().toUpper())));
+            offset = 0;
+            break;
+        }
+
+        offset += length;
+        PlcRequest req = m_inFlight.dequeue();
+
+        // 往返时间
+        double rtt = (m_clock.nsecsElapsed() - req.sentNs) / 1e6;
+        m_stats.responses++;
+        m_stats.lastRttMs = rtt;
+        m_stats.avgRttMs = m_stats.responses == 1 ? rtt : m_stats.avgRttMs * 0.9 + rtt * 0.1;
+        m_stats.maxRttMs = qMax(m_stats.maxRttMs, rtt);
+
+        handleResponse(req, reply);
+    }
+
+    // 已切出的应答一次性移出缓冲；没有在途请求时剩下的都是多余字节
+    // (补位、换行或超时后迟到的应答)，丢弃
+    if (m_inFlight.isEmpty()) m_rxBuffer.clear();
+    else if (offset > 0) m_rxBuffer.remove(0, offset);
+
+    armRequestTimer();
+    pumpRequests();
 }
 
 void PlcController::onPollTimerTimeout()
@@ -149,62 +358,85 @@ void PlcController::onPollTimerTimeout()
         return;
     }
 
-    int address = 1600; // 固定为启动信号地址
+    // 上一次读还没应答 (PLC 忙或链路慢)，不再堆积新的读请求
+    if (m_pollPending) return;
 
-    // 发送读指令 (读 1 位)
-    QByteArray cmd = buildReadPacket(address, 1);
-    m_socket->write(cmd);
-    m_socket->flush();
+    // 发送读指令 (读 1 位)，固定为启动信号地址
+    PlcRequest req;
+    req.kind = PlcRequest::ReadBits;
+    req.address = m_startAddress;
+    req.count = 1;
+    m_pollPending = true;
+    enqueue(req);
+    pumpRequests();
 }
 
-QByteArray PlcController::buildReadPacket(int address, int count)
+// [修改] 帧格式由 m_codec 决定，编码进复用的 m_txFrame
+void PlcController::encodeRequest(PlcRequest &req)
 {
-    Q_UNUSED(count);
-    int timeout = 10;
-    // 保持标准 ASCII 协议格式: 00FF + 超时 + ID(4D2) + ... + 地址
-    QString cmdStr = QString::asprintf("00FF%04X4D200000%04X0100", timeout, address);
-    return cmdStr.toLatin1();
-}
+    m_txFrame.resize(0);    // reserve 过，不会释放已分配的空间
 
-QByteArray PlcController::buildWritePacket(int address, bool value)
-{
-    int timeout = 10;
-    QString cmdStr = QString::asprintf("02FF%04X4D200000%04X0100%01X",
-                                       timeout, address, value ? 1 : 0);
-    return cmdStr.toLatin1();
-}
+    if (req.kind == PlcRequest::ReadBits) {
+        req.command = McFrameCodec::ReadBits;
+        m_codec.encodeReadBits(m_txFrame, req.address, req.count);
+        return;
+    }
 
-void PlcController::parseResponse(const QByteArray &data)
-{
-    QString resp = QString::fromLatin1(data).trimmed();
+    // D 寄存器：按字成批写
+    if (!req.frame.words.isEmpty()) {
+        req.command = McFrameCodec::WriteWords;
+        m_codec.encodeWriteWords(m_txFrame, req.frame.wordAddress, req.frame.words);
+        return;
+    }
 
-    // 读指令的响应通常是 "80000" 或 "80001" (A-1E 协议)
-    // 写指令的响应是 "8000"
-    if (resp.startsWith("8000")) {
+    // M 位：单点写与按块写的地址都是连续的，成批写
+    req.command = McFrameCodec::WriteBits;
+    m_codec.encodeWriteBits(m_txFrame, req.frame.points);
+}
 
-        // 如果长度只有 4 (即 "8000")，说明是写的响应，或者是无效读取，直接忽略
-        if (resp.length() <= 4) return;
+// [新增] 一条已与请求对上的应答
+void PlcController::handleResponse(const PlcRequest &req, const McReply &reply)
+{
+    if (req.kind == PlcRequest::ReadBits) {
+        if (req.address == m_startAddress) m_pollPending = false;
+        // 异常应答：等下一次轮询
+        if (reply.endCode != 0 || reply.bits.isEmpty()) return;
+        if (req.address == m_startAddress) handleStartSignal(reply.bits[0]);
+        return;
+    }
 
-        bool isOn = resp.endsWith("1");
+    if (reply.endCode == 0) {
+        // 同批的帧全部确认后才通知；已判失败的批次不再通知
+        auto it = m_batchFrames.find(req.frame.batchId);
+        if (req.frame.batchId && it != m_batchFrames.end() && --it.value() == 0) {
+            m_batchFrames.erase(it);
+            emit batchWritten(req.frame.batchId, true);
+        }
+        return;
+    }
+    retryOrFail(req.frame, QString("异常应答 %1 %2")
+                .arg(reply.endCode, 2, 16, QChar('0')).arg(reply.abnormalCode, 2, 16, QChar('0')));
+}
 
-        // --- 【修改后】 直接视为 M1600 (Start Signal) 的逻辑 ---
+void PlcController::handleStartSignal(bool isOn)
+{
+    // --- 【修改后】 直接视为 M1600 (Start Signal) 的逻辑 ---
 
-        if (isOn) {
-            // M1600 = 1
-            if (m_lastStartSignalVal != 1) {
-                m_lastStartSignalVal = 1;
-                qDebug() << "PLC Start Signal (M1600) Rising Edge Detected!";
-                emit logMessage(">>> [PLC] 收到启动信号 (M1600=1)");
-                emit plcStartSignalReceived(); // 触发主窗口开始测试
-            }
+    if (isOn) {
+        // M1600 = 1
+        if (m_lastStartSignalVal != 1) {
+            m_lastStartSignalVal = 1;
+            qDebug() << "PLC Start Signal (M1600) Rising Edge Detected!";
+            emit logMessage(QString(">>> [PLC] 收到启动信号 (M%1=1)").arg(m_startAddress));
+            emit plcStartSignalReceived(); // 触发主窗口开始测试
         }
-        else {
-            // M1600 = 0
-            if (m_lastStartSignalVal != 0) {
-                m_lastStartSignalVal = 0;
-                // 归零，等待下一次上升沿
-                // qDebug() << "PLC Start Signal Reset (M1600=0)";
-            }
+    }
+    else {
+        // M1600 = 0
+        if (m_lastStartSignalVal != 0) {
+            m_lastStartSignalVal = 0;
+            // 归零，等待下一次上升沿
+            // qDebug() << "PLC Start Signal Reset (M1600=0)";
         }
     }
 }
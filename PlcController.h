@@ -6,11 +6,41 @@
 #include <QMutex>
 #include <QQueue>     // [新增]
 #include <QDateTime>  // [新增]
+#include <QVector>
+#include <QElapsedTimer>
+#include <QHash>
+#include "McFrameCodec.h"   // WriteTask、帧编解码
 
-// [新增] 写入指令结构体
-struct WriteTask {
-    int address;
-    bool value;
+// [新增] 一个写入帧：单点写，一次批量写入的多个位，或一段 D 寄存器
+struct WriteFrame {
+    QVector<WriteTask> points;
+    int wordAddress = 0;    // words 非空时为 D 寄存器成批写，points 不用
+    QVector<quint16> words;
+    int batchId = 0;        // 0 = 单点写 (writeDevice)，不通知结果
+    int attempts = 0;       // 已发送次数
+};
+
+// [新增] 一条待发出或已发出、等待应答的请求
+struct PlcRequest {
+    enum Kind { ReadBits, WriteBits };
+    Kind kind = ReadBits;
+    int address = 0;        // 读：起始地址
+    int count = 0;          // 读：点数
+    WriteFrame frame;       // 写
+    McFrameCodec::Command command = McFrameCodec::ReadBits;    // 发出时确定，解码应答用
+    qint64 sentNs = 0;      // 发出时刻 (m_clock)，用于超时与往返时间
+};
+
+// [新增] 通信链路统计
+struct PlcLinkStats {
+    qint64 responses = 0;   // 收到并对上请求的应答数
+    qint64 timeouts = 0;    // 应答超时次数
+    qint64 resyncs = 0;     // 应答与请求对不上、丢弃接收缓冲重新同步的次数
+    double lastRttMs = 0.0; // 最近一次往返时间
+    double avgRttMs = 0.0;  // 往返时间滑动平均
+    double maxRttMs = 0.0;
+    int inFlight = 0;       // 当前已发出未应答的请求数
+    int queued = 0;         // 当前排队未发出的请求数
 };
 
 class PlcController : public QObject
@@ -21,10 +51,31 @@ public:
     explicit PlcController(QObject *parent = nullptr);
     ~PlcController();
 
-    void init(bool enabled, const QString &ip, int port);
+    /**
+     * @param pipelineDepth 最多同时在途 (已发出未应答) 的请求数，1 表示严格一问一答
+     * @param responseTimeoutMs 单个请求等待应答的时间
+     */
+    void init(bool enabled, const QString &ip, int port,
+              int pipelineDepth = 4, int responseTimeoutMs = 3000);
     void disconnectPlc();
     void writeDevice(int address, bool value);
 
+    // [新增] 帧格式 (ASCII 1E / 二进制 1E / 二进制 3E)，需在 init 之前设置
+    void setFrameMode(McFrameCodec::Mode mode);
+    // [新增] 启动信号 (轮询读) 与放行信号的 M 地址，默认 M1600 / M1650
+    void setSignalAddresses(int startAddress, int releaseAddress);
+
+    /**
+     * @brief [新增] 按块批量写入，每块一帧 (M 位成批写或 D 字成批写)
+     * 所有块都被 PLC 应答确认后发出 batchWritten(batchId, true)；任一块重试用尽后
+     * 发出 batchWritten(batchId, false)，同批尚未发出的块不再发送。
+     * @return 批次号；PLC 未启用或某块点数超限时返回 0 (不会有 batchWritten)
+     */
+    int writeBlocks(const QVector<WriteBlock> &blocks);
+
+    // [新增] 往返时间、超时等链路统计
+    PlcLinkStats linkStats() const;
+
 signals:
     void logMessage(const QString &msg);
     void plcStartSignalReceived();
@@ -32,6 +83,8 @@ signals:
     void connected();
     void plcDisconnected();
     void errorOccurred(const QString &msg);
+    // [新增] 批量写入已被 PLC 应答确认 (ok) 或最终失败
+    void batchWritten(int batchId, bool ok);
 
 private slots:
     void onSocketConnected();
@@ -40,13 +93,21 @@ private slots:
     void onSocketError(QAbstractSocket::SocketError socketError);
     void onPollTimerTimeout();
 
-    // [新增] 队列处理槽函数
-    void processWriteQueue();
+    // [新增] 在途请求超时
+    void onRequestTimeout();
 
 private:
-    QByteArray buildReadPacket(int address, int count);
-    QByteArray buildWritePacket(int address, bool value);
-    void parseResponse(const QByteArray &data);
+    void encodeRequest(PlcRequest &req);
+
+    // [新增] 请求队列：排队 -> 在途 -> 按顺序与应答对应
+    void enqueue(const PlcRequest &req, bool front = false);
+    void pumpRequests();
+    void armRequestTimer();
+    void handleResponse(const PlcRequest &req, const McReply &reply);
+    void handleStartSignal(bool isOn);
+    void retryOrFail(WriteFrame frame, const QString &reason);
+    int nextBatchId();
+    void failInFlight(const QString &reason);
 
 private:
     bool m_isEnabled;
@@ -57,10 +118,24 @@ private:
     QTimer *m_pollTimer;
     int m_pollStep;             // 0=读Stop(M1650), 1=读Start(M1600)
     int m_lastStartSignalVal;   // 边沿检测用
+    int m_startAddress;         // [新增] 启动信号 (默认 M1600)
+    int m_releaseAddress;       // [新增] 放行信号 (默认 M1650)
 
-    // [新增] 写入队列相关
-    QQueue<WriteTask> m_writeQueue;
-    QTimer *m_writeTimer;       // 发送间隔定时器
+    // [新增] 请求队列 (取代以前 50ms 一帧的写入定时器)
+    // 1E 帧没有序号，PLC 按收到的顺序逐条应答，所以应答与在途队列的队首对应
+    QQueue<PlcRequest> m_txQueue;   // 排队未发出
+    QQueue<PlcRequest> m_inFlight;  // 已发出等待应答
+    QByteArray m_rxBuffer;          // 收到但还不够一条完整应答的字节
+    McFrameCodec m_codec;
+    QByteArray m_txFrame;           // 编码缓冲 (预分配，每帧复用)
+    QTimer *m_requestTimer;         // 队首请求的应答期限
+    QElapsedTimer m_clock;
+    int m_pipelineDepth;
+    int m_responseTimeoutMs;
+    bool m_pollPending;             // 上一次轮询读还没应答时不再排新的
+    int m_nextBatchId;
+    QHash<int, int> m_batchFrames;  // 批次号 -> 尚未确认的帧数
+    PlcLinkStats m_stats;
 
     // [新增] 忽略停止信号的时间戳
     qint64 m_ignoreStopSignalUntil;
@@ -0,0 +1,42 @@
+#include "SerialPortPool.h"
+#include <QMutexLocker>
+
+bool SerialPortPool::acquire(const QString &portName, int channelId, int *owner)
+{
+    QMutexLocker locker(&m_mutex);
+    SerialPortStats &st = m_ports[portName];
+
+    if (st.ownerChannel != 0 && st.ownerChannel != channelId) {
+        if (owner) *owner = st.ownerChannel;
+        return false;
+    }
+    st.ownerChannel = channelId;
+    if (owner) *owner = channelId;
+    return true;
+}
+
+void SerialPortPool::release(const QString &portName, int channelId)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_ports.find(portName);
+    if (it != m_ports.end() && it->ownerChannel == channelId) {
+        it->ownerChannel = 0;
+    }
+}
+
+void SerialPortPool::recordOpen(const QString &portName, qint64 elapsedMs, bool isReopen)
+{
+    QMutexLocker locker(&m_mutex);
+    SerialPortStats &st = m_ports[portName];
+
+    if (isReopen) st.reopenCount++;
+    else st.openCount++;
+    st.lastOpenMs = elapsedMs;
+    st.maxOpenMs = qMax(st.maxOpenMs, elapsedMs);
+}
+
+SerialPortStats SerialPortPool::stats(const QString &portName) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_ports.value(portName);
+}
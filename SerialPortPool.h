@@ -0,0 +1,55 @@
+#ifndef SERIALPORTPOOL_H
+#define SERIALPORTPOOL_H
+
+#include <QString>
+#include <QMap>
+#include <QMutex>
+
+// ==========================================
+// 单个串口的打开统计
+// ==========================================
+struct SerialPortStats {
+    int ownerChannel = 0;       // 当前持有该串口的通道 (0 表示空闲)
+    int openCount = 0;          // 首次打开次数
+    int reopenCount = 0;        // 掉线/切换后重新打开次数
+    qint64 lastOpenMs = 0;      // 最近一次 open 耗时
+    qint64 maxOpenMs = 0;       // 最大一次 open 耗时
+};
+
+/**
+ * @brief 会话级串口池 (登记表)
+ * * 串口由各通道的工作线程持有并在整个会话中保持打开 (QSerialPort 有线程归属，
+ *   不能在线程间转交)，这里只负责登记：
+ * 1. 同一个串口同一时间只允许一个通道持有，防止两个通道配成同一个 COM 口。
+ * 2. 记录每个串口的打开 / 重新打开耗时，便于评估 USB 转串口的驱动开销。
+ *
+ * 所有接口线程安全。
+ */
+class SerialPortPool
+{
+public:
+    static SerialPortPool &instance() {
+        static SerialPortPool pool;
+        return pool;
+    }
+
+    // 通道申请使用某个串口；已被其他通道持有时返回 false，并通过 owner 返回持有者
+    bool acquire(const QString &portName, int channelId, int *owner = nullptr);
+    void release(const QString &portName, int channelId);
+
+    // 记录一次 open 的耗时
+    void recordOpen(const QString &portName, qint64 elapsedMs, bool isReopen);
+
+    SerialPortStats stats(const QString &portName) const;
+
+private:
+    SerialPortPool() {}
+    SerialPortPool(const SerialPortPool&) = delete;
+    SerialPortPool& operator=(const SerialPortPool&) = delete;
+
+private:
+    mutable QMutex m_mutex;
+    QMap<QString, SerialPortStats> m_ports;
+};
+
+#endif // SERIALPORTPOOL_H
@@ -0,0 +1,855 @@
+#include "SnIndex.h"
+#include <QVector>
+#include <QPair>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+namespace {
+const char kMagic[8] = { 'S', 'N', 'I', 'N', 'D', 'E', 'X', '\0' };
+
+const double kLoadFactor = 0.85;   // Robin Hood 探测下 0.85 仍能保持很短的探测距离
+const int kBloomBitsPerKey = 12;    // 分块布隆过滤器每键 12 位，误判率约 0.5%
+const int kNumericSuffixDigits = 6; // SN 末尾这么多位数字按数值存，其余并入前缀
+const int kMaxPrefixes = 16383;     // 前缀编号 varint 最多两个字节
+const int kMaxRawLength = 127;      // 描述字节里原样存储的最大长度
+const double kReverseLoadFactor = 0.7;  // 反向表线性探测，每次比对都要解码 SN，装载率取低一些
+const qint64 kMinChunkBytes = 1 << 20; // 小于 1MB 的文件不值得分线程
+const int kMaxConflictSamples = 10;
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline void trim(const char *&b, const char *&e)
+{
+    while (b < e && isBlank(*b)) ++b;
+    while (e > b && isBlank(e[-1])) --e;
+}
+
+inline qint64 align8(qint64 v)
+{
+    return (v + 7) & ~qint64(7);
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+void appendVarint(QByteArray &out, quint64 v)
+{
+    while (v >= 0x80) {
+        out.append(char(v | 0x80));
+        v >>= 7;
+    }
+    out.append(char(v));
+}
+
+inline quint64 readVarint(const uchar *&p)
+{
+    quint64 v = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        v |= quint64(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    v |= quint64(*p++) << shift;
+    return v;
+}
+
+struct Row {
+    quint64 key;
+    quint32 order;      // 文件中的行序，重复键取最后一条
+    quint32 snLength;
+    const char *sn;     // 指向 CSV 映射区，构建期间有效
+};
+
+inline bool rowLess(const Row &a, const Row &b)
+{
+    return a.key < b.key || (a.key == b.key && a.order < b.order);
+}
+
+// SN 字节串的哈希 (FNV-1a)，再经 homeSlot 打散
+quint64 snHash(const char *s, int len)
+{
+    quint64 h = 14695981039346656037ull;
+    for (int i = 0; i < len; ++i) h = (h ^ uchar(s[i])) * 1099511628211ull;
+    return h | 1; // 保证非 0
+}
+
+// 键还原成 IMSI 数字串
+QByteArray unpackKey(quint64 key)
+{
+    char digits[17];
+    int dl = int(key >> 57);
+    quint64 v = key & ((quint64(1) << 57) - 1);
+    for (int k = dl - 1; k >= 0; --k) {
+        digits[k] = char('0' + v % 10);
+        v /= 10;
+    }
+    return QByteArray(digits, dl);
+}
+
+// 一个按行对齐的 CSV 分块及其解析结果
+struct Chunk {
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    QVector<Row> rows;                              // 数字键，解析后按 (键, 行序) 排好
+    QVector<QPair<QByteArray, QByteArray>> extra;   // 非数字键，保持文件顺序
+};
+
+// 解析一个分块 (CSV 格式: IMSI,SN；只有 IMSI 的行 SN 为空)。行序从 0 开始计
+void parseChunk(Chunk &c)
+{
+    const char *p = c.begin;
+    const char *end = c.end;
+    c.rows.reserve(int((end - p) / 32));
+
+    quint32 order = 0;
+    while (p < end) {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+        const char *b = p;
+        const char *e = nl ? nl : end;
+        p = nl ? nl + 1 : end;
+
+        trim(b, e);
+        if (b == e) continue;
+
+        const char *comma = static_cast<const char *>(memchr(b, ',', size_t(e - b)));
+        const char *kb = b;
+        const char *ke = comma ? comma : e;
+        trim(kb, ke);
+
+        const char *vb = e;
+        const char *ve = e;
+        if (comma) {
+            vb = comma + 1;
+            const char *next = static_cast<const char *>(memchr(vb, ',', size_t(e - vb)));
+            ve = next ? next : e; // 多余的列忽略
+            trim(vb, ve);
+        }
+
+        quint64 key;
+        if (SnIndex::packKey(kb, int(ke - kb), &key)) {
+            Row r;
+            r.key = key;
+            r.order = order++;
+            r.sn = vb;
+            r.snLength = quint32(ve - vb);
+            c.rows.append(r);
+        } else {
+            c.extra.append(qMakePair(QByteArray(kb, int(ke - kb)), QByteArray(vb, int(ve - vb))));
+        }
+    }
+
+    std::sort(c.rows.begin(), c.rows.end(), rowLess);
+}
+
+// SN 拆成 "前缀 + 末尾最多 6 位数字"。返回前缀长度
+int splitSn(const char *sn, int len)
+{
+    int run = 0;
+    while (run < len && run < kNumericSuffixDigits && isDigit(sn[len - 1 - run])) ++run;
+    return len - run;
+}
+
+// 排好序的行按区间分给各线程统计前缀、编码 SN
+struct RowRange {
+    const Row *rows = nullptr;
+    int begin = 0;
+    int end = 0;
+    QHash<QByteArray, int> prefixUse;   // 键直接引用 CSV 映射区，不复制
+    QByteArray arena;                   // 本区间的 SN 记录，偏移从 0 起
+};
+
+const quint32 kEmptyRef = 0xFFFFFFFFu;  // 区间内暂记的空 SN
+
+void countPrefixes(RowRange &range)
+{
+    // 相邻行前缀通常相同，先和上一行比较，省掉大部分哈希查找
+    const char *last = nullptr;
+    int lastLen = 0;
+    int *lastCount = nullptr;
+    for (int i = range.begin; i < range.end; ++i) {
+        const Row &r = range.rows[i];
+        int pl = splitSn(r.sn, int(r.snLength));
+        if (pl <= 0 || pl >= int(r.snLength)) continue;
+
+        if (lastCount && pl == lastLen && memcmp(r.sn, last, size_t(pl)) == 0) {
+            ++*lastCount;
+            continue;
+        }
+        lastCount = &range.prefixUse[QByteArray::fromRawData(r.sn, pl)];
+        ++*lastCount;
+        last = r.sn;
+        lastLen = pl;
+    }
+}
+
+void encodeRange(RowRange &range, const QHash<QByteArray, quint32> &prefixId, quint32 *refs)
+{
+    QByteArray &arena = range.arena;
+    arena.reserve((range.end - range.begin) * 6);
+
+    const char *last = nullptr;
+    int lastLen = -1;
+    quint32 lastId = 0;
+    for (int i = range.begin; i < range.end; ++i) {
+        const Row &r = range.rows[i];
+        int len = int(r.snLength);
+        if (len == 0) {
+            refs[i] = kEmptyRef;
+            continue;
+        }
+        refs[i] = quint32(arena.size());
+
+        int pl = splitSn(r.sn, len);
+        quint32 id = 0;
+        if (pl > 0 && pl < len) {
+            if (pl == lastLen && memcmp(r.sn, last, size_t(pl)) == 0) {
+                id = lastId;
+            } else {
+                id = prefixId.value(QByteArray::fromRawData(r.sn, pl), 0);
+                last = r.sn;
+                lastLen = pl;
+                lastId = id;
+            }
+        }
+
+        if (id == 0 && pl > 0) {
+            // 没有共享前缀：整串原样存储
+            appendVarint(arena, 0);
+            arena.append(char(len));
+            arena.append(r.sn, len);
+            continue;
+        }
+
+        // 前缀编号 + 末尾数字 (位数 + varint 数值)
+        int digits = len - pl;
+        quint64 v = 0;
+        for (int k = pl; k < len; ++k) v = v * 10 + quint64(r.sn[k] - '0');
+        appendVarint(arena, id);
+        arena.append(char(0x80 | digits));
+        appendVarint(arena, v);
+    }
+}
+
+// 头部校验覆盖 headerChecksum 之前的所有字段
+const qint64 kHeaderChecksumSpan = qint64(offsetof(SnIndex::Header, headerChecksum));
+}
+
+bool SnIndex::packKey(const char *s, int len, quint64 *key)
+{
+    if (len <= 0 || len > 17) return false;
+
+    quint64 v = 0;
+    for (int i = 0; i < len; ++i) {
+        char c = s[i];
+        if (!isDigit(c)) return false;
+        v = v * 10 + quint64(c - '0');
+    }
+    *key = (quint64(len) << 57) | v;
+    return true;
+}
+
+bool SnIndex::packKey(const QString &s, quint64 *key)
+{
+    int len = s.size();
+    if (len <= 0 || len > 17) return false;
+
+    char buf[17];
+    const QChar *d = s.constData();
+    for (int i = 0; i < len; ++i) {
+        ushort u = d[i].unicode();
+        if (u < '0' || u > '9') return false;
+        buf[i] = char(u);
+    }
+    return packKey(buf, len, key);
+}
+
+quint64 SnIndex::checksum(const uchar *data, qint64 len)
+{
+    // 按 8 字节字做 FNV-1a，足以发现截断/损坏，速度接近内存带宽
+    quint64 h = 14695981039346656037ull;
+    qint64 words = len / 8;
+    for (qint64 i = 0; i < words; ++i) {
+        quint64 w;
+        memcpy(&w, data + i * 8, 8);
+        h = (h ^ w) * 1099511628211ull;
+    }
+    for (qint64 i = words * 8; i < len; ++i) {
+        h = (h ^ data[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+QByteArray SnIndex::build(const char *csv, qint64 len, qint64 sourceSize, qint64 sourceMtimeMs, BuildStats *stats)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const char *begin = csv;
+    const char *end = csv + len;
+    if (len >= 3 && memcmp(begin, "\xEF\xBB\xBF", 3) == 0) begin += 3; // UTF-8 BOM
+
+    // 1. 按换行切成若干块，每块在线程池里独立解析并排序
+    int chunkCount = int(qBound<qint64>(1, (end - begin) / kMinChunkBytes, QThread::idealThreadCount()));
+    QVector<Chunk> chunks(chunkCount);
+    const char *p = begin;
+    for (int i = 0; i < chunkCount; ++i) {
+        const char *stop = end;
+        if (i + 1 < chunkCount) {
+            stop = begin + (end - begin) * (i + 1) / chunkCount;
+            if (stop < p) stop = p;
+            const char *nl = static_cast<const char *>(memchr(stop, '\n', size_t(end - stop)));
+            stop = nl ? nl + 1 : end;
+        }
+        chunks[i].begin = p;
+        chunks[i].end = stop;
+        p = stop;
+    }
+
+    if (chunkCount > 1) QtConcurrent::blockingMap(chunks, parseChunk);
+    else parseChunk(chunks[0]);
+    qint64 parseMs = timer.elapsed();
+
+    // 2. 合并：块内行序加上块的起始行号，得到全文件行序；已排序的块两两归并
+    QVector<Row> rows;
+    QVector<int> bounds;
+    quint32 firstOrder = 0;
+    bounds.append(0);
+    for (Chunk &c : chunks) {
+        for (Row &r : c.rows) r.order += firstOrder;
+        firstOrder += quint32(c.rows.size());
+        rows += c.rows;
+        bounds.append(rows.size());
+        c.rows.clear();
+    }
+
+    QVector<Row> scratch(rows.size());
+    while (bounds.size() > 2) {
+        QVector<int> pairs;
+        for (int i = 0; i + 1 < bounds.size(); i += 2) pairs.append(i);
+
+        const Row *src = rows.constData();
+        Row *dst = scratch.data();
+        const QVector<int> &b = bounds;
+        auto mergePair = [src, dst, &b](int &i) {
+            if (i + 2 < b.size()) {
+                std::merge(src + b[i], src + b[i + 1], src + b[i + 1], src + b[i + 2], dst + b[i], rowLess);
+            } else {
+                std::copy(src + b[i], src + b[i + 1], dst + b[i]);
+            }
+        };
+        if (pairs.size() > 1) QtConcurrent::blockingMap(pairs, mergePair);
+        else mergePair(pairs[0]);
+
+        QVector<int> next;
+        for (int i = 0; i < bounds.size(); i += 2) next.append(bounds.at(i));
+        if (next.last() != bounds.last()) next.append(bounds.last());
+        bounds.swap(next);
+        rows.swap(scratch);
+    }
+    scratch.clear();
+
+    // 非数字键：按块顺序合并，后出现的覆盖前面的
+    QHash<QByteArray, QByteArray> extra;
+    qint64 duplicates = 0;
+    qint64 conflicts = 0;
+    QStringList samples;
+    auto noteConflict = [&](const QByteArray &key, const QByteArray &oldSn, const QByteArray &newSn) {
+        ++conflicts;
+        if (samples.size() < kMaxConflictSamples) {
+            samples.append(QString::fromUtf8(key) + ": " + QString::fromUtf8(oldSn)
+                           + " -> " + QString::fromUtf8(newSn));
+        }
+    };
+    for (const Chunk &c : chunks) {
+        for (const QPair<QByteArray, QByteArray> &kv : c.extra) {
+            auto it = extra.find(kv.first);
+            if (it != extra.end()) {
+                ++duplicates;
+                if (it.value() != kv.second) noteConflict(kv.first, it.value(), kv.second);
+                it.value() = kv.second;
+            } else {
+                extra.insert(kv.first, kv.second);
+            }
+        }
+    }
+    qint64 lines = qint64(rows.size()) + qint64(duplicates) + extra.size();
+
+    // 3. 重复键保留最后一行；同一 IMSI 对应不同 SN 的记为冲突
+    int n = 0;
+    for (int i = 0; i < rows.size(); ++i) {
+        const Row &r = rows.at(i);
+        if (i + 1 < rows.size() && rows.at(i + 1).key == r.key) {
+            ++duplicates;
+            const Row &next = rows.at(i + 1);
+            if (next.snLength != r.snLength || memcmp(next.sn, r.sn, r.snLength) != 0) {
+                noteConflict(unpackKey(r.key), QByteArray(r.sn, int(r.snLength)),
+                             QByteArray(next.sn, int(next.snLength)));
+            }
+            continue;
+        }
+
+        // 原样存储放不下的超长 SN 走附加段
+        if (int(r.snLength) > kMaxRawLength) {
+            extra.insert(unpackKey(r.key), QByteArray(r.sn, int(r.snLength)));
+            continue;
+        }
+        rows[n++] = r;
+    }
+    rows.resize(n);
+
+    // 4. 统计前缀 (按行区间并行)，出现两次以上的才值得共享
+    QVector<RowRange> ranges(chunkCount);
+    for (int i = 0; i < chunkCount; ++i) {
+        ranges[i].rows = rows.constData();
+        ranges[i].begin = int(qint64(n) * i / chunkCount);
+        ranges[i].end = int(qint64(n) * (i + 1) / chunkCount);
+    }
+    if (chunkCount > 1) QtConcurrent::blockingMap(ranges, countPrefixes);
+    else countPrefixes(ranges[0]);
+
+    QHash<QByteArray, int> prefixUse;
+    for (RowRange &range : ranges) {
+        for (auto it = range.prefixUse.constBegin(); it != range.prefixUse.constEnd(); ++it) {
+            prefixUse[it.key()] += it.value();
+        }
+        range.prefixUse.clear();
+    }
+    QVector<QPair<int, QByteArray>> ranked;
+    for (auto it = prefixUse.constBegin(); it != prefixUse.constEnd(); ++it) {
+        if (it.value() >= 2) ranked.append(qMakePair(it.value(), it.key()));
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const QPair<int, QByteArray> &a, const QPair<int, QByteArray> &b) {
+        return a.first > b.first;
+    });
+    if (ranked.size() > kMaxPrefixes) ranked.resize(kMaxPrefixes);
+
+    QHash<QByteArray, quint32> prefixId;    // 前缀 -> 编号 (从 1 开始，0 表示无前缀)
+    QVector<quint32> prefixOffsets;
+    QByteArray prefixBytes;
+    prefixOffsets.append(0);
+    for (int i = 0; i < ranked.size(); ++i) {
+        prefixId.insert(ranked.at(i).second, quint32(i + 1));
+        prefixBytes.append(ranked.at(i).second);
+        prefixOffsets.append(quint32(prefixBytes.size()));
+    }
+
+    // 5. 编码 SN 字节区：各区间编码到自己的缓冲，再按顺序拼接并修正偏移。偏移 0 固定为空 SN
+    QVector<quint32> refs(n);
+    quint32 *refData = refs.data();
+    const QHash<QByteArray, quint32> &ids = prefixId;
+    auto encode = [refData, &ids](RowRange &range) { encodeRange(range, ids, refData); };
+    if (chunkCount > 1) QtConcurrent::blockingMap(ranges, encode);
+    else encode(ranges[0]);
+
+    QByteArray arena;
+    arena.append(char(0));
+    arena.append(char(0));
+    for (RowRange &range : ranges) {
+        quint32 arenaBase = quint32(arena.size());
+        for (int i = range.begin; i < range.end; ++i) {
+            refData[i] = refData[i] == kEmptyRef ? 0 : refData[i] + arenaBase;
+        }
+        arena.append(range.arena);
+        range.arena.clear();
+    }
+
+    // 6. Robin Hood 开放寻址表：离起始槽越远的元素越优先占位。slotRows 记下每个槽对应的行，供反向表使用
+    quint64 slotCount = qMax<quint64>(8, quint64(double(n) / kLoadFactor) + 1);
+    QVector<quint64> keys(int(slotCount), 0);
+    QVector<quint32> slotRefs(int(slotCount), 0);
+    QVector<int> slotRows(int(slotCount), -1);
+    for (int i = 0; i < n; ++i) {
+        quint64 key = rows.at(i).key;
+        quint32 ref = refs.at(i);
+        int row = i;
+        quint64 slot = homeSlot(key, slotCount);
+        quint64 dist = 0;
+
+        for (;;) {
+            quint64 cur = keys.at(int(slot));
+            if (cur == 0) {
+                keys[int(slot)] = key;
+                slotRefs[int(slot)] = ref;
+                slotRows[int(slot)] = row;
+                break;
+            }
+            quint64 home = homeSlot(cur, slotCount);
+            quint64 curDist = slot >= home ? slot - home : slot + slotCount - home;
+            if (curDist < dist) {
+                std::swap(keys[int(slot)], key);
+                std::swap(slotRefs[int(slot)], ref);
+                std::swap(slotRows[int(slot)], row);
+                dist = curDist;
+            }
+            if (++slot == slotCount) slot = 0;
+            ++dist;
+        }
+    }
+
+    // 反向表 (SN -> 正向槽号 + 1)：同一遍构建，不另存 SN 和 IMSI。空 SN 不入表
+    quint64 revSlotCount = qMax<quint64>(8, quint64(double(n) / kReverseLoadFactor) + 1);
+    QVector<quint32> rev(int(revSlotCount), 0);
+    for (quint64 slot = 0; slot < slotCount; ++slot) {
+        int row = slotRows.at(int(slot));
+        if (row < 0 || rows.at(row).snLength == 0) continue;
+
+        const Row &r = rows.at(row);
+        quint64 h = homeSlot(snHash(r.sn, int(r.snLength)), revSlotCount);
+        while (rev.at(int(h)) != 0) {
+            if (++h == revSlotCount) h = 0;
+        }
+        rev[int(h)] = quint32(slot + 1);
+    }
+    slotRows.clear();
+
+    // 布隆过滤器：每个键落在一个 32 字节块里，块内 8 个字各置 1 位
+    quint64 bloomBlocks = qMax<quint64>(1, (quint64(n) * kBloomBitsPerKey + 255) / 256);
+    QVector<quint32> bloom(int(bloomBlocks * 8), 0);
+    for (int i = 0; i < n; ++i) {
+        quint64 h = bloomHash(rows.at(i).key);
+        quint32 *block = bloom.data() + bloomBlock(h, bloomBlocks) * 8;
+        for (int w = 0; w < 8; ++w) block[w] |= bloomBit(h, w);
+    }
+
+    QByteArray extraBytes;
+    for (auto it = extra.constBegin(); it != extra.constEnd(); ++it) {
+        quint32 kl = quint32(it.key().size());
+        quint32 vl = quint32(it.value().size());
+        extraBytes.append(reinterpret_cast<const char *>(&kl), 4);
+        extraBytes.append(reinterpret_cast<const char *>(&vl), 4);
+        extraBytes.append(it.key());
+        extraBytes.append(it.value());
+    }
+
+    // 7. 排版。过滤器紧跟头部，体积小，查表时常驻缓存
+    qint64 bloomOffset = align8(sizeof(Header));
+    qint64 keysOffset = bloomOffset + qint64(bloomBlocks) * 32;
+    qint64 refsOffset = keysOffset + qint64(slotCount) * 8;
+    qint64 revOffset = refsOffset + qint64(slotCount) * 4;
+    qint64 prefixOffset = align8(revOffset + qint64(revSlotCount) * 4);
+    qint64 arenaOffset = prefixOffset + qint64(prefixOffsets.size()) * 4 + prefixBytes.size();
+    qint64 extraOffset = align8(arenaOffset + arena.size());
+    qint64 total = align8(extraOffset + extraBytes.size());
+
+    QByteArray image(int(total), '\0');
+    uchar *base = reinterpret_cast<uchar *>(image.data());
+
+    memcpy(base + bloomOffset, bloom.constData(), size_t(bloomBlocks) * 32);
+    memcpy(base + keysOffset, keys.constData(), size_t(slotCount) * 8);
+    memcpy(base + refsOffset, slotRefs.constData(), size_t(slotCount) * 4);
+    memcpy(base + revOffset, rev.constData(), size_t(revSlotCount) * 4);
+    memcpy(base + prefixOffset, prefixOffsets.constData(), size_t(prefixOffsets.size()) * 4);
+    memcpy(base + prefixOffset + prefixOffsets.size() * 4, prefixBytes.constData(), size_t(prefixBytes.size()));
+    memcpy(base + arenaOffset, arena.constData(), size_t(arena.size()));
+    memcpy(base + extraOffset, extraBytes.constData(), size_t(extraBytes.size()));
+
+    Header *h = reinterpret_cast<Header *>(base);
+    memcpy(h->magic, kMagic, sizeof(kMagic));
+    h->version = Version;
+    h->headerSize = quint32(bloomOffset);
+    h->rowCount = quint64(n);
+    h->extraCount = quint64(extra.size());
+    h->sourceSize = quint64(sourceSize);
+    h->sourceMtimeMs = sourceMtimeMs;
+    h->slotCount = slotCount;
+    h->keysOffset = quint64(keysOffset);
+    h->refsOffset = quint64(refsOffset);
+    h->prefixCount = quint64(prefixOffsets.size() - 1);
+    h->prefixOffset = quint64(prefixOffset);
+    h->arenaOffset = quint64(arenaOffset);
+    h->arenaSize = quint64(arena.size());
+    h->extraOffset = quint64(extraOffset);
+    h->extraSize = quint64(extraBytes.size());
+    h->bloomOffset = quint64(bloomOffset);
+    h->bloomBlocks = bloomBlocks;
+    h->revSlotCount = revSlotCount;
+    h->revOffset = quint64(revOffset);
+    h->payloadChecksum = checksum(base + bloomOffset, total - bloomOffset);
+    h->headerChecksum = checksum(base, kHeaderChecksumSpan);
+
+    if (stats) {
+        stats->threads = chunkCount;
+        stats->lines = lines;
+        stats->duplicates = duplicates;
+        stats->conflicts = conflicts;
+        stats->conflictSamples = samples;
+        stats->parseMs = parseMs;
+        stats->totalMs = timer.elapsed();
+    }
+    return image;
+}
+
+bool SnIndex::matchesSource(const uchar *data, qint64 size, qint64 sourceSize, qint64 sourceMtimeMs)
+{
+    if (size < qint64(sizeof(Header))) return false;
+
+    const Header *h = reinterpret_cast<const Header *>(data);
+    return memcmp(h->magic, kMagic, sizeof(kMagic)) == 0
+            && h->version == Version
+            && h->headerChecksum == checksum(data, kHeaderChecksumSpan)
+            && h->sourceSize == quint64(sourceSize)
+            && h->sourceMtimeMs == sourceMtimeMs;
+}
+
+bool SnIndex::attach(const uchar *data, qint64 size, bool verifyPayload, QString *error)
+{
+    detach();
+
+    if (size < qint64(sizeof(Header))) {
+        *error = "索引文件过短";
+        return false;
+    }
+    const Header *h = reinterpret_cast<const Header *>(data);
+    if (memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != Version) {
+        *error = "索引文件版本不符";
+        return false;
+    }
+    if (h->headerChecksum != checksum(data, kHeaderChecksumSpan)) {
+        *error = "索引头校验失败";
+        return false;
+    }
+
+    // 各段必须落在文件范围内
+    quint64 usize = quint64(size);
+    if (h->slotCount == 0 || h->slotCount >= (quint64(1) << 32)
+            || h->keysOffset + h->slotCount * 8 > usize
+            || h->refsOffset + h->slotCount * 4 > usize
+            || h->prefixOffset + (h->prefixCount + 1) * 4 > usize
+            || h->arenaOffset + h->arenaSize > usize
+            || h->extraOffset + h->extraSize > usize
+            || h->bloomBlocks == 0 || h->bloomBlocks >= (quint64(1) << 32)
+            || h->bloomOffset + h->bloomBlocks * 32 > usize
+            || h->revSlotCount == 0 || h->revSlotCount >= (quint64(1) << 32)
+            || h->revOffset + h->revSlotCount * 4 > usize || (h->revOffset & 3)
+            || (h->bloomOffset & 7) || (h->keysOffset & 7) || (h->refsOffset & 3) || (h->prefixOffset & 3)) {
+        *error = "索引段越界";
+        return false;
+    }
+
+    // 全量校验会读完整个文件，默认只在需要时开启
+    if (verifyPayload && h->payloadChecksum != checksum(data + h->bloomOffset, size - qint64(h->bloomOffset))) {
+        *error = "索引数据校验失败";
+        return false;
+    }
+
+    // 附加段很小，直接读入哈希表
+    const uchar *p = data + h->extraOffset;
+    const uchar *end = p + h->extraSize;
+    while (end - p >= 8) {
+        quint32 kl, vl;
+        memcpy(&kl, p, 4);
+        memcpy(&vl, p + 4, 4);
+        p += 8;
+        if (quint64(end - p) < quint64(kl) + vl) break;
+        QString key = QString::fromUtf8(reinterpret_cast<const char *>(p), int(kl));
+        QString value = QString::fromUtf8(reinterpret_cast<const char *>(p + kl), int(vl));
+        m_extra.insert(key, value);
+        if (!value.isEmpty()) m_extraReverse.insert(value, key);
+        p += kl + vl;
+    }
+
+    m_header = h;
+    m_bloom = reinterpret_cast<const quint32 *>(data + h->bloomOffset);
+    m_keys = reinterpret_cast<const quint64 *>(data + h->keysOffset);
+    m_refs = reinterpret_cast<const quint32 *>(data + h->refsOffset);
+    m_rev = reinterpret_cast<const quint32 *>(data + h->revOffset);
+    m_prefixOffsets = reinterpret_cast<const quint32 *>(data + h->prefixOffset);
+    m_prefixBytes = reinterpret_cast<const char *>(data + h->prefixOffset + (h->prefixCount + 1) * 4);
+    m_arena = data + h->arenaOffset;
+    return true;
+}
+
+void SnIndex::detach()
+{
+    m_header = nullptr;
+    m_bloom = nullptr;
+    m_keys = nullptr;
+    m_refs = nullptr;
+    m_rev = nullptr;
+    m_prefixOffsets = nullptr;
+    m_prefixBytes = nullptr;
+    m_arena = nullptr;
+    m_extra.clear();
+    m_extraReverse.clear();
+}
+
+qint64 SnIndex::rowCount() const
+{
+    if (!m_header) return 0;
+    return qint64(m_header->rowCount + m_header->extraCount);
+}
+
+int SnIndex::findSlot(quint64 key) const
+{
+    const quint64 slotCount = m_header->slotCount;
+    quint64 slot = homeSlot(key, slotCount);
+
+    for (quint64 dist = 0; dist < slotCount; ++dist) {
+        quint64 cur = m_keys[slot];
+        if (cur == key) return int(slot);
+        if (cur == 0) return -1;
+
+        // Robin Hood：槽内元素离家更近，说明要找的键不可能在后面
+        quint64 home = homeSlot(cur, slotCount);
+        quint64 curDist = slot >= home ? slot - home : slot + slotCount - home;
+        if (curDist < dist) return -1;
+
+        if (++slot == slotCount) slot = 0;
+    }
+    return -1;
+}
+
+int SnIndex::decodeSnBytes(quint32 ref, char *out) const
+{
+    const uchar *p = m_arena + ref;
+    quint64 id = readVarint(p);
+    uchar desc = *p++;
+
+    if (!(desc & 0x80)) {
+        // 原样存储
+        int len = desc;
+        memcpy(out, p, size_t(len));
+        return len;
+    }
+
+    // 前缀 + 定长数字 (左补 0)
+    int prefixLen = 0;
+    if (id > 0 && id <= m_header->prefixCount) {
+        prefixLen = int(m_prefixOffsets[id] - m_prefixOffsets[id - 1]);
+        memcpy(out, m_prefixBytes + m_prefixOffsets[id - 1], size_t(prefixLen));
+    }
+    int digits = desc & 0x1F;
+    quint64 v = readVarint(p);
+    for (int i = prefixLen + digits - 1; i >= prefixLen; --i) {
+        out[i] = char('0' + v % 10);
+        v /= 10;
+    }
+    return prefixLen + digits;
+}
+
+void SnIndex::decodeSn(quint32 ref, QString *sn) const
+{
+    char buf[kMaxSnBytes];
+    int len = decodeSnBytes(ref, buf);
+
+    // 非 ASCII 内容按 UTF-8 解码 (少见，允许分配)
+    for (int i = 0; i < len; ++i) {
+        if (uchar(buf[i]) >= 0x80) {
+            *sn = QString::fromUtf8(buf, len);
+            return;
+        }
+    }
+
+    sn->resize(len);
+    QChar *out = sn->data();
+    for (int i = 0; i < len; ++i) out[i] = QLatin1Char(buf[i]);
+}
+
+bool SnIndex::mayContain(quint64 key) const
+{
+    quint64 h = bloomHash(key);
+    const quint32 *block = m_bloom + bloomBlock(h, m_header->bloomBlocks) * 8;
+    for (int w = 0; w < 8; ++w) {
+        quint32 bit = bloomBit(h, w);
+        if (!(block[w] & bit)) return false;
+    }
+    return true;
+}
+
+SnIndex::Outcome SnIndex::find(const QString &imsi, QString *sn) const
+{
+    if (!m_header) return NotFound;
+
+    quint64 key;
+    if (packKey(imsi, &key)) {
+        // 先查过滤器：不在表里的 IMSI 绝大多数在这里就被拒绝，不碰主表
+        Outcome miss = FilterRejected;
+        if (mayContain(key)) {
+            int slot = findSlot(key);
+            if (slot >= 0) {
+                decodeSn(m_refs[slot], sn);
+                return Found;
+            }
+            miss = FalsePositive;
+        }
+        // SN 超长的数字键不进主表和过滤器，放在附加段
+        if (m_header->extraCount == 0) return miss;
+        auto it = m_extra.constFind(imsi);
+        if (it == m_extra.constEnd()) return miss;
+        *sn = it.value();
+        return Found;
+    }
+
+    auto it = m_extra.constFind(imsi);
+    if (it == m_extra.constEnd()) return NotFound;
+    *sn = it.value();
+    return Found;
+}
+
+bool SnIndex::lookup(const QString &imsi, QString *sn) const
+{
+    return find(imsi, sn) == Found;
+}
+
+bool SnIndex::reverseLookup(const QString &sn, QString *imsi) const
+{
+    if (!m_header || sn.isEmpty()) return false;
+
+    // 扫码内容都是 ASCII，直接转到栈上；带非 ASCII 的按 UTF-8 转换
+    char buf[kMaxSnBytes];
+    QByteArray utf8;
+    const char *bytes = buf;
+    int len = sn.size();
+    bool ascii = len <= kMaxRawLength;
+    const QChar *d = sn.constData();
+    for (int i = 0; ascii && i < len; ++i) {
+        ushort u = d[i].unicode();
+        if (u >= 0x80) ascii = false;
+        else buf[i] = char(u);
+    }
+    if (!ascii) {
+        utf8 = sn.toUtf8();
+        bytes = utf8.constData();
+        len = utf8.size();
+    }
+
+    if (len <= kMaxRawLength) {
+        const quint64 revSlots = m_header->revSlotCount;
+        quint64 slot = homeSlot(snHash(bytes, len), revSlots);
+        char cand[kMaxSnBytes];
+        for (quint64 n = 0; n < revSlots; ++n) {
+            quint32 entry = m_rev[slot];
+            if (entry == 0) break;
+
+            // 反向表只存正向槽号：SN 和 IMSI 都从正向表取，逐个比对
+            quint32 fwd = entry - 1;
+            if (decodeSnBytes(m_refs[fwd], cand) == len && memcmp(cand, bytes, size_t(len)) == 0) {
+                quint64 key = m_keys[fwd];
+                int digits = int(key >> 57);
+                quint64 v = key & ((quint64(1) << 57) - 1);
+                imsi->resize(digits);
+                QChar *out = imsi->data();
+                for (int k = digits - 1; k >= 0; --k) {
+                    out[k] = QLatin1Char(char('0' + v % 10));
+                    v /= 10;
+                }
+                return true;
+            }
+            if (++slot == revSlots) slot = 0;
+        }
+    }
+
+    auto it = m_extraReverse.constFind(sn);
+    if (it == m_extraReverse.constEnd()) return false;
+    *imsi = it.value();
+    return true;
+}
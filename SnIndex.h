@@ -0,0 +1,158 @@
+#ifndef SNINDEX_H
+#define SNINDEX_H
+
+#include <QByteArray>
+#include <QString>
+#include <QHash>
+#include <QStringList>
+
+/**
+ * @brief IMSI -> SN 白名单的二进制索引
+ * * 由 CSV 构建一次，写成 <csv>.idx，之后直接内存映射使用，启动时不再逐行解析 CSV。
+ * * 索引头记录版本、源文件大小/修改时间和校验值，任何一项不符就重新构建。
+ * * 纯数字 IMSI (1~17 位) 压成 64 位整数键，存放在开放寻址表 (Robin Hood 线性探测，
+ *   装载率 0.85) 中；未命中时探测距离一超过槽内元素的距离就提前结束。
+ * * SN 存放在前缀压缩的字节区：公共前缀 (如 "SN20260115") 只存一份，
+ *   每行只存前缀编号 + 末尾数字 (varint)。每行合计约 20 字节。
+ * * 极少数非数字键 / 超长 SN 放在附加段，加载时读入一个小 QHash。
+ * * 表前附带一个分块布隆过滤器 (每键 12 位，一次查询只读一条 32 字节缓存行)，
+ *   不在表里的 IMSI 绝大多数在过滤器就被拒绝，不触碰冷的主表。
+ * * 反向表 (SN -> IMSI) 在同一遍构建，只存正向表的槽号，SN 和 IMSI 都从正向表取，
+ *   每行只多 4~6 字节。同一 SN 对应多个 IMSI 时返回其中任意一个。
+ * * 构建时大文件按换行切块，在线程池里并行解析、排序，再两两归并。
+ *
+ * 布局 (小端，各段 8 字节对齐)：
+ *   Header | bloom[bloomBlocks] (32 字节块) | keys[slotCount] (u64, 0 为空) | refs[slotCount] (u32, SN 偏移)
+ *          | rev[revSlotCount] (u32, 正向槽号 + 1) | 前缀表 | SN 字节区 | 附加段
+ */
+class SnIndex
+{
+public:
+    enum { Version = 4 };
+    enum { kMaxSnBytes = 128 };     // 表内 SN 的最大字节数 (更长的放附加段)
+
+    // 一次查找的结果，用于统计过滤器效果
+    enum Outcome {
+        Found = 0,
+        FilterRejected,     // 过滤器直接拒绝
+        FalsePositive,      // 过滤器放行但主表里没有
+        NotFound            // 非数字键未命中 (不经过过滤器)
+    };
+
+    struct Header {
+        char magic[8];              // "SNINDEX"
+        quint32 version;
+        quint32 headerSize;
+        quint64 rowCount;           // 数字键条数
+        quint64 extraCount;         // 附加段条数
+        quint64 sourceSize;         // 源 CSV 大小
+        qint64 sourceMtimeMs;       // 源 CSV 修改时间
+        quint64 slotCount;          // 哈希槽数
+        quint64 keysOffset;
+        quint64 refsOffset;
+        quint64 prefixCount;
+        quint64 prefixOffset;       // u32 偏移[prefixCount + 1]，其后是前缀字节
+        quint64 arenaOffset;        // SN 记录：varint 前缀编号 | 描述字节 | 数据
+        quint64 arenaSize;
+        quint64 extraOffset;        // 附加段：{u32 键长, u32 值长, 键, 值}...
+        quint64 extraSize;
+        quint64 bloomOffset;        // 布隆过滤器：bloomBlocks 个 32 字节块
+        quint64 bloomBlocks;
+        quint64 revSlotCount;       // 反向表 (SN -> IMSI) 槽数
+        quint64 revOffset;          // u32[revSlotCount]，存正向槽号 + 1，0 为空
+        quint64 payloadChecksum;    // 头之后全部数据的校验值
+        quint64 headerChecksum;     // 本字段之前的头部校验值
+    };
+
+    // 构建过程统计
+    struct BuildStats {
+        int threads = 1;                // 参与解析的分块数
+        qint64 lines = 0;               // 有效数据行
+        qint64 duplicates = 0;          // 被后面同一 IMSI 覆盖的行
+        qint64 conflicts = 0;           // 重复且 SN 不一致的次数
+        QStringList conflictSamples;    // 前若干条冲突，"IMSI: 旧SN -> 新SN"
+        qint64 parseMs = 0;             // 并行解析耗时
+        qint64 totalMs = 0;             // 构建总耗时
+    };
+
+    // 解析 CSV (IMSI,SN 一行一条)，生成完整的索引镜像；重复的 IMSI 以最后一行为准
+    static QByteArray build(const char *csv, qint64 len, qint64 sourceSize, qint64 sourceMtimeMs,
+                            BuildStats *stats = nullptr);
+
+    // 只检查头部：版本、源文件大小/修改时间是否一致 (不触碰数据页)
+    static bool matchesSource(const uchar *data, qint64 size, qint64 sourceSize, qint64 sourceMtimeMs);
+
+    // 挂接一段索引镜像 (mmap 或内存)；镜像的生命周期由调用方保证
+    bool attach(const uchar *data, qint64 size, bool verifyPayload, QString *error);
+    void detach();
+
+    bool isValid() const { return m_header != nullptr; }
+    qint64 rowCount() const;
+
+    // 查找 IMSI。命中时 SN 写入 *sn：复用 *sn 已有的容量，查找过程本身不分配内存
+    bool lookup(const QString &imsi, QString *sn) const;
+    Outcome find(const QString &imsi, QString *sn) const;
+
+    // 反向查找：由 SN (如扫码枪扫到的标签) 找对应的 IMSI
+    bool reverseLookup(const QString &sn, QString *imsi) const;
+
+    // IMSI 数字串 -> 64 位键：高 5 位存位数 (保留前导 0)，低 57 位存数值。键永远非 0
+    static bool packKey(const char *s, int len, quint64 *key);
+    static bool packKey(const QString &s, quint64 *key);
+
+    static quint64 checksum(const uchar *data, qint64 len);
+
+    // 键 -> 起始槽位 (乘法映射，槽数不必是 2 的幂)
+    static quint64 homeSlot(quint64 key, quint64 slotCount)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ull;
+        key ^= key >> 33;
+        return ((key >> 32) * slotCount) >> 32;
+    }
+
+    // 布隆过滤器用的第二个哈希：高 32 位选块，低 32 位乘不同的奇数盐选块内 8 个位
+    static quint64 bloomHash(quint64 key)
+    {
+        key ^= key >> 31;
+        key *= 0x9e3779b97f4a7c15ull;
+        key ^= key >> 29;
+        key *= 0xbf58476d1ce4e5b9ull;
+        key ^= key >> 32;
+        return key;
+    }
+    static quint64 bloomBlock(quint64 h, quint64 blockCount)
+    {
+        return ((h >> 32) * blockCount) >> 32;
+    }
+    static quint32 bloomBit(quint64 h, int word)
+    {
+        static const quint32 salt[8] = {
+            0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+            0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+        };
+        return quint32(1) << ((quint32(h) * salt[word]) >> 27);
+    }
+
+private:
+    bool mayContain(quint64 key) const;
+    int findSlot(quint64 key) const;
+    int decodeSnBytes(quint32 ref, char *out) const;
+    void decodeSn(quint32 ref, QString *sn) const;
+
+private:
+    const Header *m_header = nullptr;
+    const quint32 *m_bloom = nullptr;
+    const quint64 *m_keys = nullptr;
+    const quint32 *m_refs = nullptr;
+    const quint32 *m_rev = nullptr;
+    const quint32 *m_prefixOffsets = nullptr;
+    const char *m_prefixBytes = nullptr;
+    const uchar *m_arena = nullptr;
+    QHash<QString, QString> m_extra;
+    QHash<QString, QString> m_extraReverse;
+};
+
+#endif // SNINDEX_H
@@ -1,94 +1,491 @@
 #include "SnManager.h"
-#include <QFile>
-#include <QTextStream>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QElapsedTimer>
 #include <QDebug>
 #include <QMutexLocker>
+#include <QtConcurrent>
+#include <cstring>
+#include <limits>
+
+namespace {
+const qint64 kTailCheckBytes = 4096;    // 校验已并入部分末尾这么多字节，判断文件是否被改写
+const int kChangeSettleMs = 500;        // 文件通知后等这么久再读，避开写了一半的行
+}
 
 SnManager::SnManager(QObject *parent) : QObject(parent)
 {
+    m_watcher = new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &SnManager::onSourceFileChanged);
+
+    m_changeTimer = new QTimer(this);
+    m_changeTimer->setSingleShot(true);
+    m_changeTimer->setInterval(kChangeSettleMs);
+    connect(m_changeTimer, &QTimer::timeout, this, &SnManager::applySourceChange);
 }
 
 SnManager::~SnManager()
 {
+    // 后台加载还在跑时等它结束，再释放快照
+    m_reload.waitForFinished();
     clearData();
 }
 
+SnManager::BaseIndex::~BaseIndex()
+{
+    index.detach();
+    delete indexFile; // 关闭时自动解除映射
+    delete shared;    // 最后一个挂接的进程退出时系统回收共享段
+}
+
+SnManager::SnapshotPtr SnManager::snapshot() const
+{
+    return std::atomic_load(&m_snapshot);
+}
+
+void SnManager::publish(const std::shared_ptr<Snapshot> &snap)
+{
+    // 调用方已持有 m_loadMutex
+    if (snap) snap->generation = ++m_generation;
+    std::atomic_store(&m_snapshot, SnapshotPtr(snap));
+}
+
 // 加载数据文件
 bool SnManager::loadData(const QString &filePath)
 {
-    // 加锁，防止在加载过程中有线程来查表
-    QMutexLocker locker(&m_mutex);
+    // 只排斥其他加载方；查表期间照常使用旧快照
+    QMutexLocker locker(&m_loadMutex);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QFileInfo source(filePath);
+    if (!source.exists()) {
+        qWarning() << "SNManager: 无法打开文件" << filePath;
+        return false;
+    }
+    qint64 sourceSize = source.size();
+    qint64 sourceMtime = source.lastModified().toMSecsSinceEpoch();
+    QString indexPath = filePath + ".idx";
 
+    std::shared_ptr<BaseIndex> base = std::make_shared<BaseIndex>();
+    std::shared_ptr<Snapshot> snap = std::make_shared<Snapshot>();
+    snap->base = base;
+
+    // 0. 共享内存模式：其他工位进程已发布同一份索引，直接挂接
+    QString key = sharedKey(filePath, sourceSize, sourceMtime);
+    if (m_useSharedMemory && attachShared(base.get(), key, sourceSize, sourceMtime)) {
+        snap->count = int(base->index.rowCount());
+        publish(snap);
+        rememberSource(filePath, sourceSize);
+        qDebug() << "SNManager: 挂接共享索引" << key << "共" << snap->count
+                 << "条，代号" << snap->generation << "，耗时" << timer.elapsed() << "ms";
+        return true;
+    }
+    // 本进程加载成功后发布到共享内存，供其他工位进程挂接
+    auto share = [&]() {
+        if (m_useSharedMemory && publishShared(base.get(), key)) {
+            qDebug() << "SNManager: 索引已发布到共享内存" << key << base->size << "字节";
+        }
+    };
+
+    // 1. 索引文件存在且与 CSV 一致：直接映射，不解析 CSV
+    if (mapIndex(base.get(), indexPath, sourceSize, sourceMtime)) {
+        share();
+        snap->count = int(base->index.rowCount());
+        publish(snap);
+        rememberSource(filePath, sourceSize);
+        qDebug() << "SNManager: 映射索引" << indexPath << "共" << snap->count
+                 << "条，代号" << snap->generation << "，耗时" << timer.elapsed() << "ms";
+        return true;
+    }
+
+    // 2. 索引缺失或过期：解析 CSV 构建索引镜像
     QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         qWarning() << "SNManager: 无法打开文件" << filePath;
         return false;
     }
 
-    // 先清空旧数据
-    m_dataMap.clear();
+    // 大文件按行切块多线程解析
+    QByteArray image;
+    SnIndex::BuildStats stats;
+    const uchar *csv = sourceSize > 0 ? file.map(0, sourceSize) : nullptr;
+    if (csv) {
+        image = SnIndex::build(reinterpret_cast<const char *>(csv), sourceSize, sourceSize, sourceMtime, &stats);
+        file.unmap(const_cast<uchar *>(csv));
+    } else {
+        QByteArray data = file.readAll();
+        image = SnIndex::build(data.constData(), data.size(), sourceSize, sourceMtime, &stats);
+    }
+    file.close();
 
-    QTextStream in(&file);
-    // 处理中文编码，如果CSV是GBK需改为 "GBK"，这里默认UTF-8
-    in.setCodec("UTF-8");
+    qDebug() << "SNManager: 解析" << stats.lines << "行，" << stats.threads << "线程，解析"
+             << stats.parseMs << "ms / 构建" << stats.totalMs << "ms，"
+             << qRound64(stats.lines * 1000.0 / qMax<qint64>(1, stats.totalMs)) << "行/秒";
+    if (stats.conflicts > 0) {
+        // 同一 IMSI 对应不同 SN，多半是数据表合并出错，以最后一行为准但必须提示
+        qWarning() << "SNManager: 发现" << stats.conflicts << "个 IMSI 对应不同 SN (以最后一行为准)：";
+        for (const QString &sample : stats.conflictSamples) qWarning() << "    " << sample;
+    }
 
-    int loadedCount = 0;
-    while (!in.atEnd()) {
-        QString line = in.readLine().trimmed();
-        if (line.isEmpty()) continue;
+    // 3. 写索引文件 (QSaveFile 先写临时文件再改名，其他工位不会读到半个文件)
+    //    旧快照映射的是改名前的文件，不受影响
+    QSaveFile out(indexPath);
+    bool written = out.open(QIODevice::WriteOnly)
+            && out.write(image) == image.size()
+            && out.commit();
 
-        // 假设 CSV 格式为: IMSI,SN
-        // 例如: 460113362357785,SN20260115001
-        QStringList parts = line.split(',');
+    if (written && mapIndex(base.get(), indexPath, sourceSize, sourceMtime)) {
+        share();
+        snap->count = int(base->index.rowCount());
+        publish(snap);
+        rememberSource(filePath, sourceSize);
+        qDebug() << "SNManager: 由 CSV 构建索引" << indexPath << "共" << snap->count
+                 << "条，代号" << snap->generation << "，耗时" << timer.elapsed() << "ms";
+        return true;
+    }
 
-        if (parts.size() >= 2) {
-            QString imsi = parts[0].trimmed();
-            QString sn = parts[1].trimmed();
+    // 4. 目录只读等情况：直接使用内存镜像
+    QString error;
+    base->image = image;
+    if (!base->index.attach(reinterpret_cast<const uchar *>(base->image.constData()), base->image.size(), false, &error)) {
+        // 新表构建失败时不替换，旧数据仍然可用
+        qWarning() << "SNManager: 索引构建失败" << error;
+        return false;
+    }
+    base->data = reinterpret_cast<const uchar *>(base->image.constData());
+    base->size = base->image.size();
+    share();
+    snap->count = int(base->index.rowCount());
+    publish(snap);
+    rememberSource(filePath, sourceSize);
+    qWarning() << "SNManager: 无法写入索引文件" << indexPath << "，本次使用内存索引";
+    qDebug() << "SNManager: 数据加载完成，共" << snap->count << "条，代号" << snap->generation
+             << "，耗时" << timer.elapsed() << "ms";
+    return true;
+}
 
-            // 存入哈希表
-            m_dataMap.insert(imsi, sn);
-            loadedCount++;
-        }
-        else if (parts.size() == 1) {
-            // 兼容只有 IMSI 的白名单模式 (SN 为空字符串)
-            QString imsi = parts[0].trimmed();
-            m_dataMap.insert(imsi, "");
-            loadedCount++;
+void SnManager::rememberSource(const QString &filePath, qint64 consumed)
+{
+    // 调用方已持有 m_loadMutex
+    m_sourcePath = filePath;
+    m_sourceConsumed = consumed;
+
+    QFile file(filePath);
+    m_sourceTail = file.open(QIODevice::ReadOnly) ? tailChecksum(file, consumed) : 0;
+
+    // 监视器属于所属线程，后台加载时排队过去再登记
+    QMetaObject::invokeMethod(this, [this, filePath]() { watchSource(filePath); }, Qt::AutoConnection);
+}
+
+quint64 SnManager::tailChecksum(QFile &file, qint64 end)
+{
+    qint64 begin = qMax<qint64>(0, end - kTailCheckBytes);
+    if (!file.seek(begin)) return 0;
+    QByteArray tail = file.read(end - begin);
+    if (tail.size() != end - begin) return 0;
+    return SnIndex::checksum(reinterpret_cast<const uchar *>(tail.constData()), tail.size());
+}
+
+void SnManager::watchSource(const QString &filePath)
+{
+    // 整体替换文件 (先写临时文件再改名) 后监视会失效，需要重新登记
+    QStringList watched = m_watcher->files();
+    for (const QString &path : watched) {
+        if (path != filePath) m_watcher->removePath(path);
+    }
+    if (!watched.contains(filePath)) m_watcher->addPath(filePath);
+}
+
+void SnManager::onSourceFileChanged(const QString &path)
+{
+    Q_UNUSED(path);
+    // MES 往往分几次写完一批行，等文件静止一会儿再处理
+    m_changeTimer->start();
+}
+
+void SnManager::applySourceChange()
+{
+    QString filePath;
+    {
+        QMutexLocker locker(&m_loadMutex);
+        filePath = m_sourcePath;
+    }
+    if (filePath.isEmpty()) return;
+
+    // 改名替换后路径可能暂时不存在，重新登记监视
+    watchSource(filePath);
+
+    if (m_reload.isRunning()) {
+        // 整体重建进行中：重建完成后会重新记录位置，这次通知交给它
+        m_changeTimer->start();
+        return;
+    }
+
+    QMutexLocker locker(&m_loadMutex);
+    SnapshotPtr current = snapshot();
+
+    QFile file(filePath);
+    bool rewritten = !current || !file.open(QIODevice::ReadOnly)
+            || file.size() < m_sourceConsumed
+            || tailChecksum(file, m_sourceConsumed) != m_sourceTail;
+    if (rewritten) {
+        // 旧内容被改动：增量无从谈起，后台整体重建
+        locker.unlock();
+        qDebug() << "SNManager: 源文件被改写，后台重新构建" << filePath;
+        reloadAsync(filePath);
+        return;
+    }
+
+    // 只读新增部分，截到最后一个完整行
+    if (file.size() == m_sourceConsumed || !file.seek(m_sourceConsumed)) return;
+    QByteArray tail = file.read(file.size() - m_sourceConsumed);
+    int lastNewline = tail.lastIndexOf('\n');
+    if (lastNewline < 0) return; // 还没有完整的行，等下一次通知
+    tail.truncate(lastNewline + 1);
+
+    // 新快照：共用基础索引，在旧增量上叠加本次追加的行 (后出现的覆盖前面的)
+    std::shared_ptr<Snapshot> snap = std::make_shared<Snapshot>(*current);
+    const SnIndex &index = snap->base->index;
+    int rows = 0;
+    QString oldSn;
+    for (const QByteArray &rawLine : tail.split('\n')) {
+        QByteArray line = rawLine.trimmed();
+        if (line.isEmpty()) continue;
+
+        int comma = line.indexOf(',');
+        QString imsi = QString::fromUtf8(comma < 0 ? line : line.left(comma)).trimmed();
+        QString sn;
+        if (comma >= 0) sn = QString::fromUtf8(line.mid(comma + 1).split(',').first()).trimmed();
+        if (imsi.isEmpty()) continue;
+
+        // 新出现的 IMSI 才计数；覆盖的旧 SN 从反向表中去掉
+        auto it = snap->delta.constFind(imsi);
+        if (it != snap->delta.constEnd()) {
+            oldSn = it.value();
+        } else if (!index.lookup(imsi, &oldSn)) {
+            oldSn.clear();
+            snap->count++;
         }
+        if (!oldSn.isEmpty() && snap->deltaReverse.value(oldSn) == imsi) snap->deltaReverse.remove(oldSn);
+
+        snap->delta.insert(imsi, sn);
+        if (!sn.isEmpty()) snap->deltaReverse.insert(sn, imsi);
+        rows++;
     }
 
-    file.close();
-    qDebug() << "SNManager: 数据加载完成，共" << loadedCount << "条";
+    m_sourceConsumed += tail.size();
+    m_sourceTail = tailChecksum(file, m_sourceConsumed);
+    if (rows == 0) return;
+
+    publish(snap);
+    int count = snap->count;
+    quint64 generation = snap->generation;
+    locker.unlock();
+
+    qDebug() << "SNManager: 追加" << rows << "行作为增量生效，共" << count << "条，代号" << generation;
+    emit deltaApplied(rows, count, generation);
+}
+
+void SnManager::reloadAsync(const QString &filePath)
+{
+    if (m_reload.isRunning()) {
+        qWarning() << "SNManager: 上一次重新加载尚未完成，忽略本次请求";
+        return;
+    }
+
+    m_reload = QtConcurrent::run([this, filePath]() {
+        bool ok = loadData(filePath);
+        // 跨线程信号，接收方按排队连接在自己的线程处理
+        emit reloadFinished(ok, getDataCount(), getGeneration());
+    });
+}
+
+bool SnManager::mapIndex(BaseIndex *base, const QString &indexPath, qint64 sourceSize, qint64 sourceMtimeMs)
+{
+    QFile *file = new QFile(indexPath);
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        return false;
+    }
+
+    const uchar *data = file->map(0, file->size());
+    QString error;
+    if (!data || !SnIndex::matchesSource(data, file->size(), sourceSize, sourceMtimeMs)) {
+        delete file;
+        return false;
+    }
+
+    if (!base->index.attach(data, file->size(), false, &error)) {
+        qWarning() << "SNManager: 索引文件无效" << indexPath << error;
+        delete file;
+        return false;
+    }
+
+    base->indexFile = file;
+    base->data = data;
+    base->size = file->size();
+    return true;
+}
+
+QString SnManager::sharedKey(const QString &filePath, qint64 sourceSize, qint64 sourceMtimeMs)
+{
+    // 源文件一变键就变，进程不会挂接到旧数据上
+    QByteArray id = QFileInfo(filePath).absoluteFilePath().toUtf8();
+    id += '|' + QByteArray::number(sourceSize) + '|' + QByteArray::number(sourceMtimeMs);
+    quint64 h = SnIndex::checksum(reinterpret_cast<const uchar *>(id.constData()), id.size());
+    return QString("ECUTestTool.SnIndex.%1").arg(h, 16, 16, QChar('0'));
+}
+
+bool SnManager::attachShared(BaseIndex *base, const QString &key, qint64 sourceSize, qint64 sourceMtimeMs)
+{
+    QSharedMemory *shm = new QSharedMemory(key);
+    if (!shm->attach(QSharedMemory::ReadOnly)) {
+        delete shm;
+        return false;
+    }
+
+    // 发布方复制期间持有锁；头部校验通过才说明内容完整
+    shm->lock();
+    const uchar *data = static_cast<const uchar *>(shm->constData());
+    qint64 size = shm->size();
+    QString error;
+    bool ok = SnIndex::matchesSource(data, size, sourceSize, sourceMtimeMs)
+            && base->index.attach(data, size, false, &error);
+    shm->unlock();
+
+    if (!ok) {
+        base->index.detach();
+        delete shm;
+        return false;
+    }
+    base->shared = shm;
+    base->data = data;
+    base->size = size;
+    return true;
+}
+
+bool SnManager::publishShared(BaseIndex *base, const QString &key)
+{
+    // QSharedMemory 的大小是 int：超过 2GB 的索引继续用文件映射 (映射页本身也由系统在进程间共享)
+    if (!base->data || base->size <= 0 || base->size > std::numeric_limits<int>::max()) return false;
+
+    QSharedMemory *shm = new QSharedMemory(key);
+    if (!shm->create(int(base->size))) {
+        // 已存在 (其他进程抢先发布，或头部与本次源文件不符的残留段)：本进程保持现状
+        qDebug() << "SNManager: 共享内存未发布" << key << shm->errorString();
+        delete shm;
+        return false;
+    }
+
+    shm->lock();
+    memcpy(shm->data(), base->data, size_t(base->size));
+    shm->unlock();
+
+    // 本进程也改用共享段，释放文件映射 / 内存镜像，避免同一份数据占两份内存
+    SnIndex index;
+    QString error;
+    const uchar *data = static_cast<const uchar *>(shm->constData());
+    if (!index.attach(data, base->size, false, &error)) {
+        delete shm;
+        return false;
+    }
+    base->index = index;
+    base->image.clear();
+    delete base->indexFile;
+    base->indexFile = nullptr;
+    base->shared = shm;
+    base->data = data;
     return true;
 }
 
 // 核心校验函数
 bool SnManager::checkIdentity(const QString &inputCode, QString &outSn)
 {
-    // 加锁，保证读取安全性
-    QMutexLocker locker(&m_mutex);
+    // 不加锁：持有快照的引用，查表期间即使发布了新表，这份快照也不会被释放
+    SnapshotPtr snap = snapshot();
+    SnIndex::Outcome outcome = SnIndex::NotFound;
+    if (snap) {
+        // 追加的行优先 (增量表通常为空，只多一次判空)
+        auto it = snap->delta.constFind(inputCode);
+        if (it != snap->delta.constEnd()) {
+            outSn = it.value();
+            outcome = SnIndex::Found;
+        } else {
+            outcome = snap->base->index.find(inputCode, &outSn);
+        }
+    }
 
-    if (m_dataMap.contains(inputCode)) {
+    if (outcome == SnIndex::Found) {
         // 找到了！
-        outSn = m_dataMap.value(inputCode);
+        m_hits.fetchAndAddRelaxed(1);
         return true;
     }
 
     // 没找到
+    if (outcome == SnIndex::FilterRejected) m_filterRejects.fetchAndAddRelaxed(1);
+    else if (outcome == SnIndex::FalsePositive) m_falsePositives.fetchAndAddRelaxed(1);
+    else m_otherMisses.fetchAndAddRelaxed(1);
     outSn.clear();
     return false;
 }
 
+bool SnManager::findImsiBySn(const QString &sn, QString &outImsi)
+{
+    SnapshotPtr snap = snapshot();
+    if (snap) {
+        auto it = snap->deltaReverse.constFind(sn);
+        if (it != snap->deltaReverse.constEnd()) {
+            outImsi = it.value();
+            return true;
+        }
+        // 基础索引反查到的 IMSI 若已被追加行改成别的 SN，不再算数
+        if (snap->base->index.reverseLookup(sn, &outImsi)) {
+            auto over = snap->delta.constFind(outImsi);
+            if (over == snap->delta.constEnd() || over.value() == sn) return true;
+        }
+    }
+
+    outImsi.clear();
+    return false;
+}
+
 // 清空数据
 void SnManager::clearData()
 {
-    QMutexLocker locker(&m_mutex);
-    m_dataMap.clear();
+    QMutexLocker locker(&m_loadMutex);
+    publish(std::shared_ptr<Snapshot>());
+
+    // 不再跟踪源文件的追加
+    m_sourcePath.clear();
+    m_sourceConsumed = 0;
+    m_sourceTail = 0;
 }
 
 // 获取数量
 int SnManager::getDataCount() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_dataMap.size();
+    SnapshotPtr snap = snapshot();
+    return snap ? snap->count : 0;
+}
+
+quint64 SnManager::getGeneration() const
+{
+    SnapshotPtr snap = snapshot();
+    return snap ? snap->generation : 0;
+}
+
+SnLookupStats SnManager::getLookupStats() const
+{
+    SnLookupStats stats;
+    stats.hits = m_hits.loadRelaxed();
+    stats.filterRejects = m_filterRejects.loadRelaxed();
+    stats.falsePositives = m_falsePositives.loadRelaxed();
+    stats.misses = stats.filterRejects + stats.falsePositives + m_otherMisses.loadRelaxed();
+
+    qint64 filtered = stats.filterRejects + stats.falsePositives;
+    if (filtered > 0) stats.falsePositiveRate = double(stats.falsePositives) / double(filtered);
+    return stats;
 }
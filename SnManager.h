@@ -2,9 +2,27 @@
 #define SNMANAGER_H
 
 #include <QObject>
-#include <QHash>
 #include <QString>
 #include <QMutex>
+#include <QFile>
+#include <QFuture>
+#include <QAtomicInteger>
+#include <QHash>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QSharedMemory>
+#include <memory>
+
+#include "SnIndex.h"
+
+// 查表统计 (自启动以来累计)
+struct SnLookupStats {
+    qint64 hits = 0;                // 命中
+    qint64 misses = 0;              // 未命中 (含下面两项)
+    qint64 filterRejects = 0;       // 由布隆过滤器直接拒绝，未触碰主表
+    qint64 falsePositives = 0;      // 过滤器放行但主表里没有
+    double falsePositiveRate = 0.0; // falsePositives / (filterRejects + falsePositives)
+};
 
 /**
  * @brief SN 管理器类
@@ -12,6 +30,18 @@
  * 1. 从 CSV/TXT 文件加载 "IMSI - SN" 对应关系表。
  * 2. 提供线程安全的查表接口。
  * 3. 替代旧 MFC 代码中的二分查找算法 (getSn) 和硬编码数组。
+ * 4. [新增] CSV 只在第一次 (或文件变化后) 解析，结果写成二进制索引 <csv>.idx，
+ *    之后直接内存映射，启动耗时与行数无关。
+ * 5. [新增] 支持 SN -> IMSI 反查，与正向表同一遍构建、共用存储。
+ * 6. [新增] 查表不加锁：数据以只读快照发布 (shared_ptr 原子替换)。
+ *    重新加载在后台构建新快照，完成后一步替换；查表方要么用旧表、要么用新表，
+ *    不会被加载阻塞，也不会看到加载到一半的表。旧快照在最后一个查表方用完后释放。
+ * 7. [新增] 监视源文件：MES 在班中往 CSV 末尾追加的行只解析新增部分，
+ *    作为增量叠加在现有索引上发布新快照；文件被改写 (变短或旧内容变化) 时
+ *    才在后台整体重建。
+ * 8. [新增] 可选共享内存：同一台 PC 上的多个工位进程共用一份索引。
+ *    第一个加载的进程把索引镜像发布到只读共享段 (键由 CSV 路径/大小/修改时间决定)，
+ *    之后的进程直接挂接，不再映射文件或构建。
  */
 class SnManager : public QObject
 {
@@ -29,6 +59,17 @@ public:
      */
     bool loadData(const QString &filePath);
 
+    /**
+     * @brief 启用共享内存模式 (需在 loadData 之前设置)
+     */
+    void setSharedMemoryEnabled(bool enabled) { m_useSharedMemory = enabled; }
+
+    /**
+     * @brief 在后台线程重新加载，完成后发出 reloadFinished
+     * 加载期间查表继续使用旧快照
+     */
+    void reloadAsync(const QString &filePath);
+
     /**
      * @brief 检查 IMSI/SN 是否合法
      * * 对应旧代码中的 getSn + imsi2sn 逻辑。
@@ -38,6 +79,14 @@ public:
      */
     bool checkIdentity(const QString &inputCode, QString &outSn);
 
+    /**
+     * @brief 由 SN 反查 IMSI (扫码枪扫到的标签 -> 设备应有的 IMSI)
+     * @param sn 扫到的 SN
+     * @param outImsi [输出] 找到时传出对应的 IMSI
+     * @return true 表中有该 SN
+     */
+    bool findImsiBySn(const QString &sn, QString &outImsi);
+
     /**
      * @brief 清空当前内存中的数据
      * 用于切换产品或重新加载配置时
@@ -45,18 +94,90 @@ public:
     void clearData();
 
     /**
-     * @brief 获取当前加载的数据条数
+     * @brief 获取当前加载的数据条数 (含追加增量中新出现的 IMSI)
      */
     int getDataCount() const;
 
+    /**
+     * @brief 当前快照的代号，每发布一次新表 (整体重建或追加增量) 加 1 (0 表示尚未加载)
+     */
+    quint64 getGeneration() const;
+
+    /**
+     * @brief 查表命中/未命中及布隆过滤器误判统计
+     */
+    SnLookupStats getLookupStats() const;
+
+signals:
+    void reloadFinished(bool ok, int count, quint64 generation);
+    // 追加行作为增量生效
+    void deltaApplied(int rows, int count, quint64 generation);
+
+private slots:
+    void onSourceFileChanged(const QString &path);
+    void applySourceChange();
+
+private:
+    // 由 CSV 整体构建的二进制索引：优先映射 <csv>.idx 文件，写不了索引文件时退回内存镜像
+    struct BaseIndex {
+        ~BaseIndex();
+
+        SnIndex index;
+        QFile *indexFile = nullptr;
+        QByteArray image;
+        QSharedMemory *shared = nullptr;    // 共享内存模式下的只读段
+        const uchar *data = nullptr;        // 索引镜像 (以上三者之一)
+        qint64 size = 0;
+    };
+
+    // 一份只读快照：发布后不再修改，由 shared_ptr 管理生命周期
+    // 增量重载时新快照与旧快照共用同一个 BaseIndex，只有增量表不同
+    struct Snapshot {
+        std::shared_ptr<const BaseIndex> base;
+        QHash<QString, QString> delta;          // 追加行：IMSI -> SN (覆盖基础索引)
+        QHash<QString, QString> deltaReverse;   // 追加行：SN -> IMSI
+        int count = 0;                          // 基础索引 + 增量中新出现的 IMSI
+        quint64 generation = 0;
+    };
+    typedef std::shared_ptr<const Snapshot> SnapshotPtr;
+
+    SnapshotPtr snapshot() const;
+    void publish(const std::shared_ptr<Snapshot> &snap);
+    static bool mapIndex(BaseIndex *base, const QString &indexPath, qint64 sourceSize, qint64 sourceMtimeMs);
+    static QString sharedKey(const QString &filePath, qint64 sourceSize, qint64 sourceMtimeMs);
+    static bool attachShared(BaseIndex *base, const QString &key, qint64 sourceSize, qint64 sourceMtimeMs);
+    static bool publishShared(BaseIndex *base, const QString &key);
+
+    // 源文件位置：已并入快照的字节数，以及其末尾一段的校验值 (用于区分追加与改写)
+    void rememberSource(const QString &filePath, qint64 consumed);
+    static quint64 tailChecksum(QFile &file, qint64 end);
+    void watchSource(const QString &filePath);
+
 private:
-    // 内存数据库：使用哈希表存储，查询速度为 O(1)，远快于二分查找
-    // Key: IMSI (作为唯一标识)
-    // Value: SN (对应的序列号)
-    QHash<QString, QString> m_dataMap;
+    // 当前快照：只通过 std::atomic_load / std::atomic_store 访问
+    SnapshotPtr m_snapshot;
+    quint64 m_generation = 0;
+
+    bool m_useSharedMemory = false;
+
+    // 只用于串行化多个加载方 (查表不碰这把锁)
+    QMutex m_loadMutex;
+    QFuture<void> m_reload;
+
+    // 源文件监视 (只在所属线程访问)
+    QFileSystemWatcher *m_watcher = nullptr;
+    QTimer *m_changeTimer = nullptr;    // 合并 MES 分多次写入产生的连续通知
+
+    // 以下由 m_loadMutex 保护
+    QString m_sourcePath;
+    qint64 m_sourceConsumed = 0;
+    quint64 m_sourceTail = 0;
 
-    // 读写锁：防止在测试过程中重新加载文件导致崩溃
-    mutable QMutex m_mutex;
+    // 查表计数 (多个通道线程并发累加)
+    QAtomicInteger<qint64> m_hits;
+    QAtomicInteger<qint64> m_filterRejects;
+    QAtomicInteger<qint64> m_falsePositives;
+    QAtomicInteger<qint64> m_otherMisses;
 };
 
 #endif // SNMANAGER_H
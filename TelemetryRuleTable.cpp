@@ -0,0 +1,103 @@
+#include "TelemetryRuleTable.h"
+#include "TelemetryTokenizer.h"
+#include <QHash>
+#include <QDebug>
+
+// ConfigManager.h 中声明，加载配置时调用
+QSharedPointer<const TelemetryRuleTable> compileTelemetryRules(const QVector<TestRule> &rules)
+{
+    return TelemetryRuleTable::compile(rules);
+}
+
+QSharedPointer<const TelemetryRuleTable> TelemetryRuleTable::compile(const QVector<TestRule> &rules)
+{
+    QSharedPointer<TelemetryRuleTable> table(new TelemetryRuleTable);
+
+    // 1. 预解析每条规则
+    for (const TestRule &r : rules) {
+        CompiledTelemetryRule c;
+        c.key = r.key.toLocal8Bit();
+        c.name = r.name;
+        c.type = r.type;
+        c.target = r.targetVal.toLocal8Bit();
+        c.targetNum = 0;
+        c.targetIsNumeric = !c.target.isEmpty()
+                && TelemetryTokenizer::toDouble(QLatin1String(c.target.constData(), c.target.size()), &c.targetNum);
+        c.minVal = r.minVal;
+        c.maxVal = r.maxVal;
+        c.failFast = r.failFast;
+        table->m_rules.append(c);
+    }
+
+    // 2. 去重：同名 key 以最后一条为准
+    QHash<QByteArray, int> lastIndex;
+    for (int i = 0; i < table->m_rules.size(); ++i) {
+        lastIndex.insert(table->m_rules.at(i).key, i);
+    }
+    if (lastIndex.isEmpty()) return table;
+
+    // 3. 判定位图：被覆盖的重复 key 永远收不到数据，不能计入
+    table->m_requiredMask.resize((table->m_rules.size() + 63) / 64);
+    for (int w = 0; w < table->m_requiredMask.size(); ++w) table->m_requiredMask[w] = 0;
+    for (auto it = lastIndex.constBegin(); it != lastIndex.constEnd(); ++it) {
+        int i = it.value();
+        if (table->m_rules.at(i).type == Type_Display) continue;
+        table->m_requiredMask[i >> 6] |= quint64(1) << (i & 63);
+    }
+
+    // 4. 搜索完美哈希：槽位数从 2 倍 key 数起步，找不到无冲突的 seed 就翻倍
+    int slotCount = 8;
+    while (slotCount < lastIndex.size() * 2) slotCount <<= 1;
+
+    for (;;) {
+        for (quint32 seed = 0; seed < 4096; ++seed) {
+            QVector<int> slotIndex(slotCount, -1);
+            bool collision = false;
+
+            for (auto it = lastIndex.constBegin(); it != lastIndex.constEnd(); ++it) {
+                const QByteArray &k = it.key();
+                int pos = int(hash(seed, k.constData(), k.size()) & quint32(slotCount - 1));
+                if (slotIndex.at(pos) >= 0) {
+                    collision = true;
+                    break;
+                }
+                slotIndex[pos] = it.value();
+            }
+
+            if (!collision) {
+                table->m_slots = slotIndex;
+                table->m_slotMask = quint32(slotCount - 1);
+                table->m_seed = seed;
+                qDebug() << "遥测规则表编译完成: 规则" << table->m_rules.size()
+                         << "槽位" << slotCount << "seed" << seed;
+                return table;
+            }
+        }
+        slotCount <<= 1;
+    }
+}
+
+bool TelemetryRuleTable::passes(int index, QLatin1String val) const
+{
+    const CompiledTelemetryRule &r = m_rules.at(index);
+
+    switch (r.type) {
+    case Type_Match:
+    case Type_NotMatch: {
+        bool equal = (val.size() == r.target.size()
+                      && memcmp(val.data(), r.target.constData(), size_t(val.size())) == 0);
+        if (!equal && r.targetIsNumeric) {
+            double num = 0;
+            equal = TelemetryTokenizer::toDouble(val, &num) && num == r.targetNum;
+        }
+        return r.type == Type_Match ? equal : !equal;
+    }
+    case Type_Range: {
+        double num = 0;
+        TelemetryTokenizer::toDouble(val, &num);
+        return num >= r.minVal && num <= r.maxVal;
+    }
+    default:
+        return !val.isEmpty() && !(val == QLatin1String("0"));
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef TELEMETRYRULETABLE_H
+#define TELEMETRYRULETABLE_H
+
+#include <QByteArray>
+#include <QLatin1String>
+#include <QSharedPointer>
+#include <QVector>
+#include <QVarLengthArray>
+#include <cstring>
+
+#include "ConfigManager.h"
+
+// ==========================================
+// 编译后的单条遥测规则
+// ==========================================
+struct CompiledTelemetryRule {
+    QByteArray key;         // 驻留的 key 字节 (本地 8 位编码，与串口原始字节一致)
+    QString name;           // 界面显示名
+    TestType type;
+    QByteArray target;      // match / not_match 的目标值字节 (编码同 key)
+    bool targetIsNumeric;   // 目标值是数字时按数值比较 ("1" 与 "1.0" 视为相等)
+    double targetNum;
+    double minVal;
+    double maxVal;
+    int failFast;           // -1 跟随全局策略，0 关，1 开
+};
+
+/**
+ * @brief 只读的遥测规则表
+ * * 每次加载配置时由 ConfigManager 编译一次，之后在各通道线程间共享 (不可变，无需加锁)。
+ * * key 查找使用加载时构造的完美哈希：一次哈希 + 一次 memcmp，没有 QMap/QString 比较。
+ * * 数值目标、区间在编译时就解析好，热路径上不再做字符串转换。
+ */
+class TelemetryRuleTable
+{
+public:
+    static QSharedPointer<const TelemetryRuleTable> compile(const QVector<TestRule> &rules);
+
+    int size() const { return m_rules.size(); }
+    const CompiledTelemetryRule &rule(int index) const { return m_rules.at(index); }
+
+    // 返回规则索引，找不到返回 -1。同名 key 以最后一条规则为准 (与旧的 QMap 行为一致)
+    int indexOf(QLatin1String key) const
+    {
+        if (m_slots.isEmpty()) return -1;
+        int idx = m_slots.at(int(hash(m_seed, key.data(), key.size()) & m_slotMask));
+        if (idx < 0) return -1;
+        const QByteArray &k = m_rules.at(idx).key;
+        if (k.size() != key.size() || memcmp(k.constData(), key.data(), size_t(key.size())) != 0) return -1;
+        return idx;
+    }
+
+    // 判定一个采样值是否合格 (Display 类型由调用方单独处理)
+    bool passes(int index, QLatin1String val) const;
+
+    // 参与 PASS 判定的规则位图 (非 Display 且能被 indexOf 命中)，编译时算好
+    const QVarLengthArray<quint64, 2> &requiredMask() const { return m_requiredMask; }
+
+private:
+    static quint32 hash(quint32 seed, const char *data, int len)
+    {
+        // FNV-1a，seed 参与初始值，用于搜索无冲突的完美哈希
+        quint32 h = 2166136261u ^ seed;
+        for (int i = 0; i < len; ++i) {
+            h ^= quint8(data[i]);
+            h *= 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+
+private:
+    QVector<CompiledTelemetryRule> m_rules;
+    QVector<int> m_slots;       // 哈希槽 -> 规则索引 (-1 为空)
+    QVarLengthArray<quint64, 2> m_requiredMask;
+    quint32 m_slotMask = 0;
+    quint32 m_seed = 0;
+};
+
+#endif // TELEMETRYRULETABLE_H
@@ -0,0 +1,182 @@
+#ifndef TELEMETRYTOKENIZER_H
+#define TELEMETRYTOKENIZER_H
+
+#include <QtGlobal>
+#include <QLatin1String>
+#include <cstring>
+#include <cstdlib>
+
+/**
+ * @brief $info 遥测行的零分配切分器
+ * * 直接在串口原始字节上工作 (QLatin1String 只是视图)，替代
+ *   QString::split(',') -> split(':') -> trimmed() 的写法。
+ * * 分隔符 ',' ':' 都是 ASCII，GBK/UTF-8 的多字节编码里不会出现这两个字节，
+ *   所以按字节切分对中文内容同样安全。
+ * * 逗号查找使用 memchr (各平台 CRT 均为 SIMD 实现)。
+ *
+ * 保留 "t:<t1>,<t2>" 的特殊格式：t 的值映射给 t1，紧随的纯数字映射给 t2。
+ */
+namespace TelemetryTokenizer {
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+inline QLatin1String trimmed(QLatin1String s)
+{
+    const char *b = s.data();
+    const char *e = b + s.size();
+    while (b < e && isSpace(*b)) ++b;
+    while (e > b && isSpace(e[-1])) --e;
+    return QLatin1String(b, int(e - b));
+}
+
+// 在视图中查找子串，返回下标，找不到返回 -1
+inline int indexOf(QLatin1String hay, const char *needle)
+{
+    const int n = int(strlen(needle));
+    const char *p = hay.data();
+    const char *end = p + hay.size();
+    while (end - p >= n) {
+        const char *hit = static_cast<const char *>(memchr(p, needle[0], size_t(end - p - n + 1)));
+        if (!hit) return -1;
+        if (memcmp(hit, needle, size_t(n)) == 0) return int(hit - hay.data());
+        p = hit + 1;
+    }
+    return -1;
+}
+
+inline bool equalsIgnoreCase(QLatin1String s, char c)
+{
+    return s.size() == 1 && (s.data()[0] | 0x20) == (c | 0x20);
+}
+
+/**
+ * @brief ASCII 数值解析 (不分配内存、不受系统 locale 影响)
+ * 与 QString::toDouble 一致：格式非法时返回 false，*out 置 0。
+ */
+inline bool toDouble(QLatin1String s, double *out)
+{
+    static const double kPow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    *out = 0;
+    s = trimmed(s);
+    const char *p = s.data();
+    const char *end = p + s.size();
+    if (p == end) return false;
+
+    bool neg = false;
+    if (*p == '+' || *p == '-') { neg = (*p == '-'); ++p; }
+
+    quint64 mant = 0;
+    int digits = 0;      // 有效数字个数 (不含前导 0)
+    int scale = 0;       // 小数位数
+    bool any = false;
+
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        any = true;
+        if (mant || *p != '0') ++digits;
+        if (digits <= 19) mant = mant * 10 + quint64(*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+            any = true;
+            if (mant || *p != '0') ++digits;
+            if (digits <= 19) { mant = mant * 10 + quint64(*p - '0'); ++scale; }
+        }
+    }
+    if (!any) return false;
+
+    int exp10 = 0;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool expNeg = false;
+        if (p < end && (*p == '+' || *p == '-')) { expNeg = (*p == '-'); ++p; }
+        if (p == end || *p < '0' || *p > '9') return false;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            if (exp10 < 10000) exp10 = exp10 * 10 + (*p - '0');
+        }
+        if (expNeg) exp10 = -exp10;
+    }
+    if (p != end) return false;
+
+    exp10 -= scale;
+
+    // 快速路径：尾数可精确表示且 10 的幂在 1e22 以内，结果与 strtod 完全一致
+    if (digits <= 15 && exp10 >= -22 && exp10 <= 22) {
+        double v = double(mant);
+        v = exp10 < 0 ? v / kPow10[-exp10] : v * kPow10[exp10];
+        *out = neg ? -v : v;
+        return true;
+    }
+
+    // 罕见的长数字/大指数：拷贝到栈上交给 strtod
+    char buf[64];
+    if (s.size() >= int(sizeof(buf))) return false;
+    memcpy(buf, s.data(), size_t(s.size()));
+    buf[s.size()] = '\0';
+    *out = strtod(buf, nullptr);
+    return true;
+}
+
+/**
+ * @brief 切分 $info 之后的数据部分
+ * @param sink 回调 sink(key, val)，key/val 均为已去除首尾空白的视图
+ * @return 是否有任何 key:value 被处理 (对应旧代码的 anyUpdate)
+ */
+template <typename Sink>
+bool tokenize(QLatin1String dataPart, Sink &&sink)
+{
+    static const QLatin1String kT1("t1");
+    static const QLatin1String kT2("t2");
+
+    const char *p = dataPart.data();
+    const char *end = p + dataPart.size();
+    bool isNextT2 = false; // 标记位：下一个纯数字是否为 t2
+    bool anyUpdate = false;
+
+    while (p < end) {
+        const char *comma = static_cast<const char *>(memchr(p, ',', size_t(end - p)));
+        const char *partEnd = comma ? comma : end;
+        QLatin1String part = trimmed(QLatin1String(p, int(partEnd - p)));
+        p = comma ? comma + 1 : end;
+
+        if (part.isEmpty()) continue;
+
+        const char *colon = static_cast<const char *>(memchr(part.data(), ':', size_t(part.size())));
+
+        // --- 情况 A: 标准的 key:value (例如 t:0.776) ---
+        if (colon) {
+            const char *partStop = part.data() + part.size();
+            // 与旧代码 split(':').size() == 2 一致：多于一个冒号的项忽略
+            if (memchr(colon + 1, ':', size_t(partStop - colon - 1))) continue;
+
+            QLatin1String key = trimmed(QLatin1String(part.data(), int(colon - part.data())));
+            QLatin1String val = trimmed(QLatin1String(colon + 1, int(partStop - colon - 1)));
+
+            if (equalsIgnoreCase(key, 't')) {
+                sink(kT1, val);
+                isNextT2 = true;
+            } else {
+                sink(key, val);
+                isNextT2 = false;
+            }
+            anyUpdate = true;
+        }
+        // --- 情况 B: 没有冒号的纯数值 (例如 35)，上一个项是 t 时映射给 t2 ---
+        else if (isNextT2) {
+            sink(kT2, part);
+            isNextT2 = false;
+            anyUpdate = true;
+        }
+    }
+    return anyUpdate;
+}
+
+} // namespace TelemetryTokenizer
+
+#endif // TELEMETRYTOKENIZER_H
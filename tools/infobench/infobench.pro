@@ -0,0 +1,25 @@
+# $info 遥测解析基准 (独立控制台程序，不进主程序)
+# 用法见 main.cpp 开头的说明
+QT       += core
+QT       -= gui
+
+TARGET = infobench
+TEMPLATE = app
+
+CONFIG += c++11 release console
+CONFIG -= app_bundle
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 快速路径直接编译主程序的切分器与规则表，测的就是现场跑的代码
+SOURCES += \
+    ../../TelemetryRuleTable.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../ConfigManager.h \
+    ../../TelemetryRuleTable.h \
+    ../../TelemetryTokenizer.h
+
+INCLUDEPATH += $$PWD/../..
+
+DEFINES += __stddef_h_builtins
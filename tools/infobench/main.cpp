@@ -0,0 +1,316 @@
+/**
+ * $info 遥测解析基准
+ *
+ * 用合成的 $info 行对比两条解析路径 (与 ChannelWorker 的配置项 telemetry_fast_path 对应)：
+ *   - 旧路径：fromLocal8Bit + trimmed + split(',') / split(':')，再转回字节查规则表
+ *             (照搬 ChannelWorker::handleLine / parseLine / parseTelemetryLegacy)
+ *   - 快速路径：TelemetryTokenizer 在原始字节上切分，界面日志按一次串口读取合并
+ *             (直接用主程序的 TelemetryTokenizer.h / TelemetryRuleTable.cpp)
+ * 两条路径都用同一张规则表做 indexOf + passes 判定；样本行带一个中文 match 目标，
+ * 开跑前先核对它能判为合格 (规则表与串口字节须同为本地 8 位编码)。
+ *
+ * 每条路径统计 ns/行 与 堆分配次数/行、字节/行。
+ * 堆分配计数替换全局 malloc (glibc) 或挂 CRT 分配钩子 (MSVC Debug)；
+ * 其他平台 (如 MinGW) 拦不到 Qt 容器的 malloc，分配次数输出 -1，只看耗时。
+ *
+ *   infobench [--lines 200000] [--per-read 8] [--json infobench.json]
+ */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFile>
+#include <QVector>
+#include <QStringList>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#include "TelemetryRuleTable.h"
+#include "TelemetryTokenizer.h"
+
+// -----------------------------------------------------------
+// 堆分配计数
+// -----------------------------------------------------------
+namespace {
+std::atomic<qint64> g_allocs(0);
+std::atomic<qint64> g_allocBytes(0);
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void __libc_free(void *);
+
+void *malloc(size_t n)
+{
+    g_allocs++;
+    g_allocBytes += qint64(n);
+    return __libc_malloc(n);
+}
+void *calloc(size_t n, size_t size)
+{
+    g_allocs++;
+    g_allocBytes += qint64(n * size);
+    return __libc_calloc(n, size);
+}
+void *realloc(void *p, size_t n)
+{
+    g_allocs++;
+    g_allocBytes += qint64(n);
+    return __libc_realloc(p, n);
+}
+void free(void *p)
+{
+    __libc_free(p);
+}
+}
+static const bool kCountsMalloc = true;
+#elif defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+static int allocHook(int type, void *, size_t n, int, long, const unsigned char *, int)
+{
+    if (type == _HOOK_ALLOC || type == _HOOK_REALLOC) {
+        g_allocs++;
+        g_allocBytes += qint64(n);
+    }
+    return TRUE;
+}
+static const bool kCountsMalloc = true;
+#else
+static const bool kCountsMalloc = false;
+#endif
+
+namespace {
+// 非 ASCII 的 match 目标 (配置里的中文状态值)，串口上是本地 8 位编码的字节
+const char *const kModeText = "正常";
+
+// 与现场 $info 行同样的格式：t:<t1>,<t2> 特殊格式、数值与文本混排
+QVector<QByteArray> makeLines(int count)
+{
+    const QByteArray mode = QString::fromUtf8(kModeText).toLocal8Bit();
+    QVector<QByteArray> lines;
+    lines.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QByteArray line = "[12:00:00.000] $info,v:";
+        line += QByteArray::number(4.1 + (i % 17) * 0.005, 'f', 3);
+        line += ",t:";
+        line += QByteArray::number(0.7 + (i % 13) * 0.01, 'f', 3);
+        line += ",";
+        line += QByteArray::number(30 + i % 9);
+        line += ",pwr:1,temp:";
+        line += QByteArray::number(35.0 + (i % 11) * 0.5, 'f', 1);
+        line += ",rssi:-";
+        line += QByteArray::number(60 + i % 20);
+        line += ",mode:";
+        line += mode;
+        line += ",ver: V1.2.3 \r";
+        lines.append(line);
+    }
+    return lines;
+}
+
+QSharedPointer<const TelemetryRuleTable> makeRules()
+{
+    QVector<TestRule> rules;
+    auto add = [&](const char *key, TestType type, double lo, double hi, const char *target) {
+        TestRule r;
+        r.key = key;
+        r.name = key;
+        r.type = type;
+        r.targetVal = QString::fromUtf8(target);
+        r.minVal = lo;
+        r.maxVal = hi;
+        r.enable = true;
+        rules.append(r);
+    };
+    add("v", Type_Range, 4.0, 4.3, "");
+    add("t1", Type_Range, 0.0, 1.0, "");
+    add("t2", Type_Range, 20, 45, "");
+    add("pwr", Type_Match, 0, 0, "1");
+    add("temp", Type_Range, 20, 60, "");
+    add("rssi", Type_Range, -90, -40, "");
+    add("mode", Type_Match, 0, 0, kModeText);
+    add("ver", Type_Display, 0, 0, "");
+    return TelemetryRuleTable::compile(rules);
+}
+
+// 两条路径共用的判定 (ChannelWorker::updateResultItem 中不涉及界面的部分)
+struct Judge {
+    explicit Judge(const TelemetryRuleTable *t) : table(t) {}
+    const TelemetryRuleTable *table;
+    qint64 passed = 0;
+    void operator()(QLatin1String key, QLatin1String val)
+    {
+        int index = table->indexOf(key);
+        if (index >= 0 && table->rule(index).type != Type_Display && table->passes(index, val)) passed++;
+    }
+};
+
+// ---- 旧路径 ----
+void legacyItem(Judge &judge, const QString &key, const QString &val)
+{
+    QByteArray k = key.toLocal8Bit();
+    QByteArray v = val.toLocal8Bit();
+    judge(QLatin1String(k.constData(), k.size()), QLatin1String(v.constData(), v.size()));
+}
+
+void legacyLine(Judge &judge, const QByteArray &raw, QStringList *log)
+{
+    QString line = QString::fromLocal8Bit(raw.constData(), raw.size()).trimmed();
+    if (line.isEmpty()) return;
+
+    QString cleanLine = line.trimmed();
+    if (cleanLine.contains("$info,")) {
+        int start = cleanLine.indexOf("$info,");
+        const QStringList parts = cleanLine.mid(start + 6).split(',', Qt::SkipEmptyParts);
+        bool isNextT2 = false;
+        for (const QString &part : parts) {
+            QString cleanPart = part.trimmed();
+            if (cleanPart.contains(':')) {
+                QStringList kv = cleanPart.split(':');
+                if (kv.size() == 2) {
+                    QString key = kv[0].trimmed();
+                    QString val = kv[1].trimmed();
+                    if (key.compare("t", Qt::CaseInsensitive) == 0) {
+                        legacyItem(judge, "t1", val);
+                        isNextT2 = true;
+                    } else {
+                        legacyItem(judge, key, val);
+                        isNextT2 = false;
+                    }
+                }
+            } else if (!cleanPart.isEmpty() && isNextT2) {
+                legacyItem(judge, "t2", cleanPart);
+                isNextT2 = false;
+            }
+        }
+    }
+    log->append(line);      // emit logLine(line)
+}
+
+// ---- 快速路径 ----
+void fastLine(Judge &judge, const QByteArray &raw, QByteArray *batch)
+{
+    QLatin1String view(raw.constData(), raw.size());
+    int pos = TelemetryTokenizer::indexOf(view, "$info,");
+    if (pos < 0) return;
+    TelemetryTokenizer::tokenize(QLatin1String(view.data() + pos + 6, view.size() - pos - 6), judge);
+
+    QLatin1String text = TelemetryTokenizer::trimmed(view);
+    if (!batch->isEmpty()) batch->append('\n');
+    batch->append(text.data(), text.size());
+}
+
+struct PathResult {
+    double nsPerLine = 0;
+    double allocsPerLine = 0;
+    double bytesPerLine = 0;
+    qint64 passed = 0;
+};
+
+template <typename Fn>
+PathResult measure(const QVector<QByteArray> &lines, int perRead, Fn &&fn)
+{
+    PathResult r;
+    // 预热一遍 (静态数据、首次扩容不计入)
+    for (int i = 0; i < qMin(lines.size(), 1000); ++i) fn(lines.at(i), (i + 1) % perRead == 0);
+
+    qint64 allocs0 = g_allocs, bytes0 = g_allocBytes;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < lines.size(); ++i) fn(lines.at(i), (i + 1) % perRead == 0);
+    qint64 ns = timer.nsecsElapsed();
+
+    r.nsPerLine = double(ns) / lines.size();
+    r.allocsPerLine = kCountsMalloc ? double(g_allocs - allocs0) / lines.size() : -1;
+    r.bytesPerLine = kCountsMalloc ? double(g_allocBytes - bytes0) / lines.size() : -1;
+    return r;
+}
+
+QJsonObject toJson(const PathResult &r)
+{
+    QJsonObject o;
+    o["nsPerLine"] = r.nsPerLine;
+    o["allocsPerLine"] = r.allocsPerLine;
+    o["bytesPerLine"] = r.bytesPerLine;
+    o["passed"] = double(r.passed);
+    return o;
+}
+}
+
+int main(int argc, char *argv[])
+{
+#if defined(_MSC_VER) && defined(_DEBUG)
+    _CrtSetAllocHook(allocHook);
+#endif
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("$info 遥测解析基准 (旧路径 vs 快速路径)");
+    parser.addHelpOption();
+    QCommandLineOption linesOpt("lines", "行数", "n", "200000");
+    QCommandLineOption perReadOpt("per-read", "每次串口读取包含的行数 (快速路径按此合并界面日志)", "n", "8");
+    QCommandLineOption jsonOpt("json", "结果写入 JSON 文件", "file");
+    parser.addOptions({ linesOpt, perReadOpt, jsonOpt });
+    parser.process(app);
+
+    int count = qMax(1000, parser.value(linesOpt).toInt());
+    int perRead = qMax(1, parser.value(perReadOpt).toInt());
+
+    QVector<QByteArray> lines = makeLines(count);
+    QSharedPointer<const TelemetryRuleTable> table = makeRules();
+
+    // 非 ASCII 目标值：规则表与串口字节须是同一种编码，否则永远判 NG
+    const QByteArray mode = QString::fromUtf8(kModeText).toLocal8Bit();
+    int modeIndex = table->indexOf(QLatin1String("mode"));
+    if (modeIndex < 0 || !table->passes(modeIndex, QLatin1String(mode.constData(), mode.size()))) {
+        fprintf(stderr, "infobench: 非 ASCII 的 match 目标判定失败\n");
+        return 1;
+    }
+
+    Judge legacyJudge(table.data());
+    QStringList log;
+    PathResult legacy = measure(lines, perRead, [&](const QByteArray &raw, bool endOfRead) {
+        legacyLine(legacyJudge, raw, &log);
+        if (endOfRead) log.clear();     // 界面侧取走
+    });
+    legacy.passed = legacyJudge.passed;
+
+    Judge fastJudge(table.data());
+    QByteArray batch;
+    batch.reserve(4096);
+    QString sent;
+    PathResult fast = measure(lines, perRead, [&](const QByteArray &raw, bool endOfRead) {
+        fastLine(fastJudge, raw, &batch);
+        if (endOfRead) {                // ChannelWorker::flushInfoLog
+            sent = QString::fromLocal8Bit(batch.constData(), batch.size());
+            batch.resize(0);
+        }
+    });
+    fast.passed = fastJudge.passed;
+
+    printf("%-10s %12s %14s %14s\n", "path", "ns/line", "allocs/line", "bytes/line");
+    printf("%-10s %12.1f %14.2f %14.1f\n", "legacy", legacy.nsPerLine, legacy.allocsPerLine, legacy.bytesPerLine);
+    printf("%-10s %12.1f %14.2f %14.1f\n", "fast", fast.nsPerLine, fast.allocsPerLine, fast.bytesPerLine);
+    if (!kCountsMalloc) printf("(本平台无法统计 malloc，分配次数为 -1)\n");
+    if (legacy.passed != fast.passed) {
+        fprintf(stderr, "infobench: 两条路径的判定结果不一致 (%lld vs %lld)\n",
+                (long long)legacy.passed, (long long)fast.passed);
+        return 1;
+    }
+
+    if (parser.isSet(jsonOpt)) {
+        QJsonObject o;
+        o["lines"] = count;
+        o["perRead"] = perRead;
+        o["legacy"] = toJson(legacy);
+        o["fast"] = toJson(fast);
+        QFile out(parser.value(jsonOpt));
+        if (out.open(QIODevice::WriteOnly | QIODevice::Truncate)) out.write(QJsonDocument(o).toJson());
+    }
+    return 0;
+}
@@ -0,0 +1,327 @@
+/**
+ * MC 协议帧编解码自检
+ *
+ * 用固定的字节向量核对 McFrameCodec 的三种帧格式 (ascii1e / binary1e / binary3e)：
+ *   - 编码：读启动位 M1600、写放行位 M1650、11 点成批写 M1655~M1665、D100 两个字，逐字节比对
+ *   - 解码：单条应答、粘包 (几条应答连成一段)、半帧 (逐字节/按 3 字节喂入)、
+ *           1E 异常应答 5B + 异常代码、3E 异常结束代码、与请求不符的应答
+ * 全部通过后测编码、解码的 ns/帧，改动编解码前后各跑一次即可对比。
+ * 任一项不符时打印期望/实际并以 1 退出。
+ *
+ *   mcframetest [--iterations 1000000] [--json mcframetest.json]
+ */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+#include <QVector>
+#include <cstdio>
+
+#include "McFrameCodec.h"
+
+namespace {
+int g_checks = 0;
+int g_failures = 0;
+
+void check(bool ok, const QString &what)
+{
+    g_checks++;
+    if (ok) return;
+    g_failures++;
+    fprintf(stderr, "FAIL %s\n", qPrintable(what));
+}
+
+QString hexText(const QByteArray &b)
+{
+    return QString::fromLatin1(b.toHex(' ').toUpper());
+}
+
+void checkBytes(const QString &what, const QByteArray &actual, const QByteArray &expected)
+{
+    check(actual == expected, QString("%1\n    期望: %2\n    实际: %3")
+                                  .arg(what, hexText(expected), hexText(actual)));
+}
+
+// 各帧格式下的期望字节 (按手册逐字段核对过，不从编码器生成)
+struct Vectors {
+    McFrameCodec::Mode mode;
+    // 编码
+    QByteArray read;        // 读 M1600 1 点
+    QByteArray write1;      // 写 M1650 = 1
+    QByteArray write11;     // 写 M1655~M1665 = 1,0,0,1,0,0,1,0,0,1,0
+    QByteArray words;       // 写 D100 = 0x0005, 0x8001
+    // 应答
+    QByteArray readOn;      // 读 1 点正常应答，值为 1
+    QByteArray writeOk;     // 位写正常应答
+    QByteArray wordsOk;     // 字写正常应答
+    QByteArray abnormal;    // 位写异常应答
+    int abnormalEnd;
+    int abnormalCode;
+    QByteArray pad;         // 粘包时两条应答之间的填充 (ASCII 奇数点读补 '0')
+};
+
+QVector<Vectors> vectors()
+{
+    QVector<Vectors> v;
+
+    Vectors a;
+    a.mode = McFrameCodec::Ascii1E;
+    a.read = "00FF000A4D20000006400100";
+    a.write1 = "02FF000A4D200000067201001";
+    a.write11 = "02FF000A4D20000006770B0010010010010";
+    a.words = "03FF000A442000000064020000058001";
+    a.readOn = "80001";
+    a.writeOk = "8200";
+    a.wordsOk = "8300";
+    a.abnormal = "825B10";
+    a.abnormalEnd = 0x5B;
+    a.abnormalCode = 0x10;
+    a.pad = "0";
+    v.append(a);
+
+    Vectors b;
+    b.mode = McFrameCodec::Binary1E;
+    b.read = QByteArray::fromHex("00FF0A0040060000204D0100");
+    b.write1 = QByteArray::fromHex("02FF0A0072060000204D010010");
+    b.write11 = QByteArray::fromHex("02FF0A0077060000204D0B00100100100100");
+    b.words = QByteArray::fromHex("03FF0A00640000002044020005000180");
+    b.readOn = QByteArray::fromHex("800010");
+    b.writeOk = QByteArray::fromHex("8200");
+    b.wordsOk = QByteArray::fromHex("8300");
+    b.abnormal = QByteArray::fromHex("825B10");
+    b.abnormalEnd = 0x5B;
+    b.abnormalCode = 0x10;
+    v.append(b);
+
+    Vectors c;
+    c.mode = McFrameCodec::Binary3E;
+    c.read = QByteArray::fromHex("500000FFFF03000C000A0001040100400600900100");
+    c.write1 = QByteArray::fromHex("500000FFFF03000D000A000114010072060090010010");
+    c.write11 = QByteArray::fromHex("500000FFFF030012000A0001140100770600900B00100100100100");
+    c.words = QByteArray::fromHex("500000FFFF030010000A0001140000640000A8020005000180");
+    c.readOn = QByteArray::fromHex("D00000FFFF030003000000" "10");
+    c.writeOk = QByteArray::fromHex("D00000FFFF030002000000");
+    c.wordsOk = c.writeOk;
+    // 结束代码 C051 + 出错信息 (网络号 ~ 子指令，9 字节)
+    c.abnormal = QByteArray::fromHex("D00000FFFF03000B0051C0" "00FFFF0300011401" "00");
+    c.abnormalEnd = 0xC051;
+    c.abnormalCode = 0;
+    v.append(c);
+
+    return v;
+}
+
+QVector<WriteTask> points11()
+{
+    QVector<WriteTask> pts;
+    for (int i = 0; i < 11; ++i) pts.append({ 1655 + i, i % 3 == 0 });
+    return pts;
+}
+
+QVector<quint16> words2()
+{
+    return QVector<quint16>() << 0x0005 << 0x8001;
+}
+
+void testEncode(const McFrameCodec &codec, const Vectors &v)
+{
+    QString mode = McFrameCodec::modeName(v.mode);
+    QByteArray out;
+
+    codec.encodeReadBits(out, 1600, 1);
+    checkBytes(mode + " 读 M1600", out, v.read);
+
+    out.resize(0);
+    codec.encodeWriteBits(out, QVector<WriteTask>() << WriteTask{ 1650, true });
+    checkBytes(mode + " 写 M1650", out, v.write1);
+
+    out.resize(0);
+    codec.encodeWriteBits(out, points11());
+    checkBytes(mode + " 写 M1655~M1665", out, v.write11);
+
+    out.resize(0);
+    codec.encodeWriteWords(out, 100, words2());
+    checkBytes(mode + " 写 D100~D101", out, v.words);
+
+    // 追加编码：前面已有内容时不影响新帧 (3E 数据长度按本帧回填)
+    out = "xx";
+    codec.encodeWriteWords(out, 100, words2());
+    checkBytes(mode + " 追加编码", out, "xx" + v.words);
+}
+
+// 一条请求及其应答的期望
+struct Expect {
+    McFrameCodec::Command cmd;
+    int points;
+    int endCode;
+    int abnormalCode;
+    int bit;        // 读位应答的第一点，-1 不检查
+};
+
+// 模拟 PlcController 的接收缓冲：按 chunk 字节分批到达，能切出一条就按在途顺序对上一条
+void testStream(const McFrameCodec &codec, const Vectors &v, int chunk)
+{
+    QString what = QString("%1 应答流 (每次 %2 字节)").arg(McFrameCodec::modeName(v.mode)).arg(chunk);
+    const QVector<Expect> expects = {
+        { McFrameCodec::ReadBits, 1, 0, 0, 1 },
+        { McFrameCodec::WriteBits, 0, 0, 0, -1 },
+        { McFrameCodec::WriteWords, 0, 0, 0, -1 },
+        { McFrameCodec::WriteBits, 0, v.abnormalEnd, v.abnormalCode, -1 },
+    };
+    QByteArray stream = v.readOn + v.pad + v.writeOk + v.wordsOk + v.abnormal;
+
+    QByteArray rx;
+    int next = 0;
+    for (int fed = 0; fed < stream.size(); fed += chunk) {
+        rx.append(stream.mid(fed, chunk));
+        while (next < expects.size()) {
+            const Expect &e = expects.at(next);
+            McReply reply;
+            int used = codec.decode(rx.constData(), rx.size(), e.cmd, e.points, &reply);
+            if (used < 0) {
+                check(false, QString("%1: 第 %2 条应答与请求不符 [%3]").arg(what).arg(next + 1).arg(hexText(rx)));
+                return;
+            }
+            if (used == 0) break;
+
+            bool ok = reply.endCode == e.endCode && reply.abnormalCode == e.abnormalCode
+                      && (e.bit < 0 || (reply.bits.size() == e.points && reply.bits[0] == (e.bit != 0)));
+            check(ok, QString("%1: 第 %2 条应答 结束代码 %3 异常代码 %4")
+                          .arg(what).arg(next + 1)
+                          .arg(reply.endCode, 0, 16).arg(reply.abnormalCode, 0, 16));
+            rx.remove(0, used);
+            next++;
+        }
+    }
+    check(next == expects.size() && rx.isEmpty(),
+          QString("%1: 只切出 %2/%3 条，剩余 [%4]").arg(what).arg(next).arg(expects.size()).arg(hexText(rx)));
+}
+
+void testDecode(const McFrameCodec &codec, const Vectors &v)
+{
+    QString mode = McFrameCodec::modeName(v.mode);
+    McReply reply;
+
+    // 半帧：不够一条时一律返回 0 (ASCII 的前导填充也不算完整)
+    for (int len = 0; len < v.readOn.size(); ++len) {
+        int used = codec.decode(v.readOn.constData(), len, McFrameCodec::ReadBits, 1, &reply);
+        check(used == 0, QString("%1 半帧 %2/%3 字节返回 %4").arg(mode).arg(len).arg(v.readOn.size()).arg(used));
+    }
+    for (int len = 0; len < v.abnormal.size(); ++len) {
+        int used = codec.decode(v.abnormal.constData(), len, McFrameCodec::WriteBits, 0, &reply);
+        check(used == 0, QString("%1 异常应答半帧 %2/%3 字节返回 %4").arg(mode).arg(len).arg(v.abnormal.size()).arg(used));
+    }
+
+    // 与请求不符：写应答当成读应答
+    int used = codec.decode(v.writeOk.constData(), v.writeOk.size(), McFrameCodec::ReadBits, 1, &reply);
+    check(used < 0, QString("%1 写应答按读请求解码返回 %2").arg(mode).arg(used));
+
+    if (v.mode == McFrameCodec::Binary3E) {
+        // 3E 应答不带指令，只能靠副头部和数据长度识别
+        QByteArray bad = v.writeOk;
+        bad[0] = char(0x82);
+        used = codec.decode(bad.constData(), bad.size(), McFrameCodec::WriteBits, 0, &reply);
+        check(used < 0, QString("%1 副头部不符返回 %2").arg(mode).arg(used));
+    } else {
+        // 1E 应答带指令回显：字写应答不能当位写应答
+        used = codec.decode(v.wordsOk.constData(), v.wordsOk.size(), McFrameCodec::WriteBits, 0, &reply);
+        check(used < 0, QString("%1 字写应答按位写请求解码返回 %2").arg(mode).arg(used));
+    }
+
+    // 粘包与分批到达
+    testStream(codec, v, 1);
+    testStream(codec, v, 3);
+    testStream(codec, v, 1 << 20);
+}
+
+// ---- 计时 ----
+template <typename Fn>
+double nsPerOp(int iterations, Fn &&fn)
+{
+    for (int i = 0; i < qMin(iterations, 1000); ++i) fn();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) fn();
+    return double(timer.nsecsElapsed()) / iterations;
+}
+
+QJsonObject timeMode(const McFrameCodec &codec, const Vectors &v, int iterations)
+{
+    QByteArray out;
+    out.reserve(1024);
+    const QVector<WriteTask> pts = points11();
+    const QVector<quint16> words = words2();
+    qint64 sink = 0;
+    McReply reply;
+
+    QJsonObject o;
+    o["mode"] = McFrameCodec::modeName(v.mode);
+    o["encodeRead"] = nsPerOp(iterations, [&] { out.resize(0); codec.encodeReadBits(out, 1600, 1); sink += out.size(); });
+    o["encodeWrite11"] = nsPerOp(iterations, [&] { out.resize(0); codec.encodeWriteBits(out, pts); sink += out.size(); });
+    o["encodeWords"] = nsPerOp(iterations, [&] { out.resize(0); codec.encodeWriteWords(out, 100, words); sink += out.size(); });
+    o["decodeRead"] = nsPerOp(iterations, [&] {
+        sink += codec.decode(v.readOn.constData(), v.readOn.size(), McFrameCodec::ReadBits, 1, &reply);
+    });
+    o["decodeWrite"] = nsPerOp(iterations, [&] {
+        sink += codec.decode(v.writeOk.constData(), v.writeOk.size(), McFrameCodec::WriteBits, 0, &reply);
+    });
+    if (sink == 0) fprintf(stderr, "\n");   // 防止循环被整个优化掉
+    return o;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("MC 协议帧编解码自检 (ascii1e / binary1e / binary3e)");
+    parser.addHelpOption();
+    QCommandLineOption iterOpt("iterations", "计时的循环次数 (0 不计时)", "n", "1000000");
+    QCommandLineOption jsonOpt("json", "计时结果写入 JSON 文件", "file");
+    parser.addOptions({ iterOpt, jsonOpt });
+    parser.process(app);
+
+    const QVector<Vectors> all = vectors();
+    for (const Vectors &v : all) {
+        McFrameCodec codec(v.mode);
+        testEncode(codec, v);
+        testDecode(codec, v);
+    }
+
+    if (g_failures > 0) {
+        fprintf(stderr, "mcframetest: %d/%d 项不符\n", g_failures, g_checks);
+        return 1;
+    }
+    fprintf(stderr, "mcframetest: %d 项全部通过\n", g_checks);
+
+    int iterations = parser.value(iterOpt).toInt();
+    if (iterations <= 0) return 0;
+
+    QJsonArray results;
+    printf("%-10s %12s %14s %12s %12s %12s  (ns/帧)\n",
+           "mode", "enc-read", "enc-write11", "enc-words", "dec-read", "dec-write");
+    for (const Vectors &v : all) {
+        QJsonObject o = timeMode(McFrameCodec(v.mode), v, iterations);
+        printf("%-10s %12.1f %14.1f %12.1f %12.1f %12.1f\n", qPrintable(o["mode"].toString()),
+               o["encodeRead"].toDouble(), o["encodeWrite11"].toDouble(), o["encodeWords"].toDouble(),
+               o["decodeRead"].toDouble(), o["decodeWrite"].toDouble());
+        results.append(o);
+    }
+
+    if (parser.isSet(jsonOpt)) {
+        QFile out(parser.value(jsonOpt));
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            fprintf(stderr, "mcframetest: 无法写入 %s\n", qPrintable(out.fileName()));
+            return 1;
+        }
+        QJsonObject o;
+        o["iterations"] = iterations;
+        o["results"] = results;
+        out.write(QJsonDocument(o).toJson());
+    }
+    return 0;
+}
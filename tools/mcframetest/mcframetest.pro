@@ -0,0 +1,23 @@
+# MC 协议帧编解码自检 (独立控制台程序，不进主程序)
+# 用法见 main.cpp 开头的说明
+QT       += core
+QT       -= gui
+
+TARGET = mcframetest
+TEMPLATE = app
+
+CONFIG += c++11 release console
+CONFIG -= app_bundle
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 直接编译主程序的编解码源码，测的就是现场跑的代码
+SOURCES += \
+    ../../McFrameCodec.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../McFrameCodec.h
+
+INCLUDEPATH += $$PWD/../..
+
+DEFINES += __stddef_h_builtins
@@ -0,0 +1,683 @@
+#include "PlcSimulator.h"
+#include <QJsonArray>
+#include <algorithm>
+#include <limits>
+
+namespace {
+const int kMemoryBits = 8192;       // M0 ~ M8191
+const int kMergeHoldMs = 200;       // 扣住的应答最多等这么久
+const int kSplitGapMs = 20;         // 半帧两段之间的间隔
+
+// 1E 模拟的异常代码 (结束代码 5B 之后)；3E 的结束代码
+const int kAbnormal1E = 0x10;
+const int kError3E = 0xC059;
+
+int hexField(const QByteArray &b, int pos, int digits)
+{
+    bool ok = false;
+    int v = b.mid(pos, digits).toInt(&ok, 16);
+    return ok ? v : -1;
+}
+
+quint32 le(const QByteArray &b, int pos, int bytes)
+{
+    quint32 v = 0;
+    for (int i = 0; i < bytes; ++i) v |= quint32(quint8(b.at(pos + i))) << (i * 8);
+    return v;
+}
+
+void putLe(QByteArray &out, quint32 v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) out.append(char((v >> (i * 8)) & 0xFF));
+}
+
+// 二进制位数据: 每字节 2 点，高 4 位在前
+bool packedBit(const QByteArray &b, int pos, int i)
+{
+    quint8 v = quint8(b.at(pos + i / 2));
+    return ((i & 1) ? (v & 0x0F) : (v >> 4)) != 0;
+}
+
+int command3E(int command)
+{
+    return command == 0x00 ? 0x0401 : command == 0x04 ? 0x1402 : 0x1401;
+}
+}
+
+PlcSimulator::PlcSimulator(const SimOptions &opt, QObject *parent)
+    : QObject(parent), m_opt(opt), m_random(opt.seed)
+{
+    m_memory.fill(false, kMemoryBits);
+    m_words.fill(0, kMemoryBits);
+    m_clock.start();
+
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &PlcSimulator::onNewConnection);
+
+    m_scriptTimer = new QTimer(this);
+    m_scriptTimer->setSingleShot(true);
+    connect(m_scriptTimer, &QTimer::timeout, this, &PlcSimulator::runScript);
+}
+
+bool PlcSimulator::start()
+{
+    if (!m_server->listen(QHostAddress::Any, m_opt.port)) {
+        emit log(QString("无法监听端口 %1: %2").arg(m_opt.port).arg(m_server->errorString()));
+        return false;
+    }
+    emit log(QString("监听端口 %1，帧格式 %2，应答延迟 %3±%4 ms")
+             .arg(m_opt.port).arg(m_opt.frame).arg(m_opt.latencyMs).arg(m_opt.jitterMs));
+    if (!m_script.isEmpty()) QTimer::singleShot(0, this, &PlcSimulator::runScript);
+    return true;
+}
+
+bool PlcSimulator::bit(int address) const
+{
+    return address >= 0 && address < kMemoryBits && m_memory.at(address);
+}
+
+bool PlcSimulator::chance(double p)
+{
+    return p > 0.0 && m_random.generateDouble() < p;
+}
+
+// -----------------------------------------------------------
+// 脚本
+// -----------------------------------------------------------
+bool PlcSimulator::setScript(const QStringList &lines, QString *error)
+{
+    m_script.clear();
+    for (int n = 0; n < lines.size(); ++n) {
+        QString line = lines.at(n).section('#', 0, 0).trimmed();
+        if (line.isEmpty()) continue;
+
+        QStringList f = line.split(' ', Qt::SkipEmptyParts);
+        QString op = f.at(0).toLower();
+        Step s;
+        bool ok = true;
+
+        auto device = [&](const QString &text) {
+            if (!text.startsWith('M', Qt::CaseInsensitive)) { ok = false; return 0; }
+            int a = text.mid(1).toInt(&ok);
+            if (a < 0 || a >= kMemoryBits) ok = false;
+            return a;
+        };
+
+        if (op == "delay" && f.size() == 2) {
+            s.op = Step::Delay;
+            s.ms = f.at(1).toInt(&ok);
+        } else if ((op == "set" || op == "wait") && f.size() >= 3) {
+            s.op = op == "set" ? Step::Set : Step::Wait;
+            s.address = device(f.at(1));
+            s.value = f.at(2) == "1";
+            if (ok && s.op == Step::Wait && f.size() > 3) s.ms = f.at(3).toInt(&ok);
+        } else if (op == "log") {
+            s.op = Step::Log;
+            s.text = line.mid(3).trimmed();
+        } else if (op == "loop" && f.size() == 1) {
+            s.op = Step::Loop;
+        } else if (op == "end" && f.size() == 1) {
+            s.op = Step::End;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            if (error) *error = QString("脚本第 %1 行无法识别: %2").arg(n + 1).arg(lines.at(n));
+            m_script.clear();
+            return false;
+        }
+        m_script.append(s);
+    }
+    m_pc = 0;
+    return true;
+}
+
+// 顺序执行，直到遇到 delay / 未满足的 wait
+void PlcSimulator::runScript()
+{
+    m_scriptTimer->stop();
+    int budget = 1000;  // 没有 delay 的死循环脚本也不会卡住事件循环
+
+    while (m_pc < m_script.size()) {
+        if (--budget == 0) {
+            m_scriptTimer->start(1);
+            return;
+        }
+
+        const Step &s = m_script.at(m_pc);
+        qint64 now = m_clock.elapsed();
+        switch (s.op) {
+        case Step::Delay:
+            m_pc++;
+            m_scriptTimer->start(s.ms);
+            return;
+        case Step::Set:
+            writeBit(s.address, s.value, false);
+            m_pc++;
+            break;
+        case Step::Wait:
+            if (bit(s.address) == s.value) {
+                m_waitDeadlineMs = -1;
+                m_pc++;
+                break;
+            }
+            if (m_waitDeadlineMs < 0) {
+                m_waitDeadlineMs = s.ms > 0 ? now + s.ms : std::numeric_limits<qint64>::max();
+            }
+            if (now >= m_waitDeadlineMs) {
+                emit log(QString("等待 M%1=%2 超时 (%3 ms)").arg(s.address).arg(s.value ? 1 : 0).arg(s.ms));
+                m_waitDeadlineMs = -1;
+                m_pc++;
+                break;
+            }
+            // 客户端写入时也会立即重查，这里只兜底超时
+            m_scriptTimer->start(int(qMin<qint64>(100, m_waitDeadlineMs - now)));
+            return;
+        case Step::Log:
+            emit log(s.text);
+            m_pc++;
+            break;
+        case Step::Loop:
+            m_pc = 0;
+            break;
+        case Step::End:
+            m_pc = m_script.size();
+            break;
+        }
+    }
+
+    emit scriptFinished();
+}
+
+// -----------------------------------------------------------
+// 连接与请求
+// -----------------------------------------------------------
+void PlcSimulator::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        Connection conn;
+        if (m_opt.frame == "ascii1e") conn.frame = Ascii1E;
+        else if (m_opt.frame == "binary1e") conn.frame = Binary1E;
+        else if (m_opt.frame == "binary3e") conn.frame = Binary3E;
+        m_connections.insert(socket, conn);
+
+        connect(socket, &QTcpSocket::readyRead, this, &PlcSimulator::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, &PlcSimulator::onDisconnected);
+        emit log(QString("客户端接入 %1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort()));
+    }
+}
+
+void PlcSimulator::onDisconnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket) return;
+    m_connections.remove(socket);
+    socket->deleteLater();
+    emit log("客户端断开");
+}
+
+void PlcSimulator::onReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket || !m_connections.contains(socket)) return;
+
+    m_connections[socket].rx += socket->readAll();
+
+    while (true) {
+        Connection &conn = m_connections[socket];
+        if (conn.rx.isEmpty()) break;
+        if (conn.frame == Unknown) {
+            conn.frame = detectFrame(conn.rx);
+            if (conn.frame == Unknown) {
+                m_badFrames++;
+                emit log(QString("无法识别的帧 %1，断开").arg(QString::fromLatin1(conn.rx.left(16).toHex())));
+                socket->abort();
+                return;
+            }
+            emit log(QString("识别为 %1").arg(conn.frame == Ascii1E ? "ascii1e" : conn.frame == Binary1E ? "binary1e" : "binary3e"));
+        }
+
+        Request req;
+        int length = parseRequest(conn.frame, conn.rx, &req);
+        if (length == 0) break;         // 半帧，等后续数据
+        if (length < 0) {
+            m_badFrames++;
+            emit log(QString("请求帧格式错误 %1，断开").arg(QString::fromLatin1(conn.rx.left(32).toHex())));
+            socket->abort();
+            return;
+        }
+        conn.rx.remove(0, length);
+        Frame frame = conn.frame;
+
+        // 故障注入 (abort 会同步触发 disconnected，之后不能再碰 conn)
+        if (chance(m_opt.disconnectRate)) {
+            m_disconnects++;
+            emit log("[故障] 断开连接");
+            socket->abort();
+            return;
+        }
+        if (chance(m_opt.silentRate)) {
+            m_silent++;
+            emit log("[故障] 丢弃请求，不应答");
+            continue;
+        }
+
+        queueReply(socket, execute(frame, req));
+    }
+
+    // 客户端写入可能满足了脚本正在等的条件
+    if (m_pc < m_script.size() && m_script.at(m_pc).op == Step::Wait) runScript();
+}
+
+PlcSimulator::Frame PlcSimulator::detectFrame(const QByteArray &rx) const
+{
+    quint8 c = quint8(rx.at(0));
+    if (c == '0') return Ascii1E;           // "00FF" / "02FF" / "03FF" / "04FF"
+    if (c == 0x50) return Binary3E;
+    if (c == 0x00 || c == 0x02 || c == 0x03 || c == 0x04) return Binary1E;
+    return Unknown;
+}
+
+int PlcSimulator::parseRequest(Frame frame, const QByteArray &rx, Request *req) const
+{
+    switch (frame) {
+    case Ascii1E: return parseAscii1E(rx, req);
+    case Binary1E: return parseBinary1E(rx, req);
+    case Binary3E: return parseBinary3E(rx, req);
+    default: return -1;
+    }
+}
+
+// 指令(2) PLC号(2) 定时器(4) | 读/成批写: 设备(4) 地址(8) 点数(2) 00 [每点 1 字符 | 字: 每字 4 字符]
+//                           | 随机写: 点数(2) 00 {设备(4) 地址(8) 01/00}
+int PlcSimulator::parseAscii1E(const QByteArray &rx, Request *req) const
+{
+    if (rx.size() < 8) return 0;
+    req->command = hexField(rx, 0, 2);
+
+    if (req->command == ReadBits || req->command == WriteBits) {
+        if (rx.size() < 24) return 0;
+        req->supported = hexField(rx, 8, 4) == 0x4D20;
+        req->address = hexField(rx, 12, 8);
+        req->count = hexField(rx, 20, 2);
+        if (req->address < 0 || req->count < 0) return -1;
+        if (req->count == 0) req->count = 256;
+        if (req->command == ReadBits) return 24;
+
+        if (rx.size() < 24 + req->count) return 0;
+        for (int i = 0; i < req->count; ++i) req->points.append({ req->address + i, rx.at(24 + i) == '1' });
+        return 24 + req->count;
+    }
+
+    if (req->command == WriteWords) {
+        if (rx.size() < 24) return 0;
+        req->supported = hexField(rx, 8, 4) == 0x4420;
+        req->address = hexField(rx, 12, 8);
+        req->count = hexField(rx, 20, 2);
+        if (req->address < 0 || req->count <= 0) return -1;
+        int length = 24 + 4 * req->count;
+        if (rx.size() < length) return 0;
+        for (int i = 0; i < req->count; ++i) {
+            int w = hexField(rx, 24 + 4 * i, 4);
+            if (w < 0) return -1;
+            req->words.append(quint16(w));
+        }
+        return length;
+    }
+
+    if (req->command == RandomWriteBits) {
+        if (rx.size() < 12) return 0;
+        req->count = hexField(rx, 8, 2);
+        if (req->count <= 0) return -1;
+        int length = 12 + 14 * req->count;
+        if (rx.size() < length) return 0;
+        for (int i = 0; i < req->count; ++i) {
+            int pos = 12 + 14 * i;
+            if (hexField(rx, pos, 4) != 0x4D20) req->supported = false;
+            int address = hexField(rx, pos + 4, 8);
+            if (address < 0) return -1;
+            req->points.append({ address, hexField(rx, pos + 12, 2) == 1 });
+        }
+        return length;
+    }
+    return -1;
+}
+
+// 指令(1) PLC号(1) 定时器(2) | 读/成批写: 地址(4) 设备(2) 点数(1) 00 [每字节 2 点 | 字: 每字 2 字节]
+//                           | 随机写: 点数(1) 00 {地址(4) 设备(2) 01/00(1)}
+int PlcSimulator::parseBinary1E(const QByteArray &rx, Request *req) const
+{
+    if (rx.size() < 4) return 0;
+    req->command = quint8(rx.at(0));
+
+    if (req->command == ReadBits || req->command == WriteBits) {
+        if (rx.size() < 12) return 0;
+        req->address = int(le(rx, 4, 4));
+        req->supported = le(rx, 8, 2) == 0x4D20;
+        req->count = quint8(rx.at(10));
+        if (req->count == 0) req->count = 256;
+        if (req->command == ReadBits) return 12;
+
+        int length = 12 + (req->count + 1) / 2;
+        if (rx.size() < length) return 0;
+        for (int i = 0; i < req->count; ++i) req->points.append({ req->address + i, packedBit(rx, 12, i) });
+        return length;
+    }
+
+    if (req->command == WriteWords) {
+        if (rx.size() < 12) return 0;
+        req->address = int(le(rx, 4, 4));
+        req->supported = le(rx, 8, 2) == 0x4420;
+        req->count = quint8(rx.at(10));
+        if (req->count == 0) return -1;
+        int length = 12 + 2 * req->count;
+        if (rx.size() < length) return 0;
+        for (int i = 0; i < req->count; ++i) req->words.append(quint16(le(rx, 12 + 2 * i, 2)));
+        return length;
+    }
+
+    if (req->command == RandomWriteBits) {
+        if (rx.size() < 6) return 0;
+        req->count = quint8(rx.at(4));
+        if (req->count == 0) return -1;
+        int length = 6 + 7 * req->count;
+        if (rx.size() < length) return 0;
+        for (int i = 0; i < req->count; ++i) {
+            int pos = 6 + 7 * i;
+            if (le(rx, pos + 4, 2) != 0x4D20) req->supported = false;
+            req->points.append({ int(le(rx, pos, 4)), rx.at(pos + 6) != 0 });
+        }
+        return length;
+    }
+    return -1;
+}
+
+// 50 00 网络号 PLC号 模块IO号(2) 站号 数据长度(2) | 定时器(2) 指令(2) 子指令(2) ...
+//   读/成批写: 地址(3) 设备(1) 点数(2) [每字节 2 点 | 字: 每字 2 字节]；随机写: 点数(1) {地址(3) 设备(1) 01/00(1)}
+int PlcSimulator::parseBinary3E(const QByteArray &rx, Request *req) const
+{
+    if (rx.size() < 9) return 0;
+    if (quint8(rx.at(0)) != 0x50 || rx.at(1) != 0) return -1;
+    int length = 9 + int(le(rx, 7, 2));
+    if (length < 15) return -1;
+    if (rx.size() < length) return 0;
+
+    int cmd = int(le(rx, 11, 2));
+    int sub = int(le(rx, 13, 2));
+    if (cmd == 0x1401 && sub == 0x0000) {
+        // 按字成批写，只支持 D
+        if (length < 21) return -1;
+        req->command = WriteWords;
+        req->address = int(le(rx, 15, 3));
+        req->supported = quint8(rx.at(18)) == 0xA8;
+        req->count = int(le(rx, 19, 2));
+        if (length < 21 + 2 * req->count) return -1;
+        for (int i = 0; i < req->count; ++i) req->words.append(quint16(le(rx, 21 + 2 * i, 2)));
+        return length;
+    }
+
+    req->supported = sub == 0x0001;             // 其余只支持按位
+    if (cmd == 0x0401 || cmd == 0x1401) {
+        if (length < 21) return -1;
+        req->command = cmd == 0x0401 ? ReadBits : WriteBits;
+        req->address = int(le(rx, 15, 3));
+        if (quint8(rx.at(18)) != 0x90) req->supported = false;
+        req->count = int(le(rx, 19, 2));
+        if (req->command == WriteBits) {
+            if (length < 21 + (req->count + 1) / 2) return -1;
+            for (int i = 0; i < req->count; ++i) req->points.append({ req->address + i, packedBit(rx, 21, i) });
+        }
+        return length;
+    }
+    if (cmd == 0x1402) {
+        req->command = RandomWriteBits;
+        req->count = quint8(rx.at(15));
+        if (length < 16 + 5 * req->count) return -1;
+        for (int i = 0; i < req->count; ++i) {
+            int pos = 16 + 5 * i;
+            if (quint8(rx.at(pos + 3)) != 0x90) req->supported = false;
+            req->points.append({ int(le(rx, pos, 3)), rx.at(pos + 4) != 0 });
+        }
+        return length;
+    }
+
+    // 不认识的指令：按异常应答，不断开
+    req->command = ReadBits;
+    req->supported = false;
+    return length;
+}
+
+QByteArray PlcSimulator::execute(Frame frame, const Request &req)
+{
+    m_requests[req.command]++;
+
+    bool ok = req.supported;
+    if (ok && req.command == ReadBits) ok = req.address >= 0 && req.address + req.count <= kMemoryBits;
+    for (const Point &p : req.points) {
+        if (p.address < 0 || p.address >= kMemoryBits) ok = false;
+    }
+    if (ok && req.command == WriteWords) ok = req.address >= 0 && req.address + req.words.size() <= kMemoryBits;
+    if (ok && chance(m_opt.errorRate)) {
+        m_errors++;
+        emit log("[故障] 异常应答");
+        ok = false;
+    }
+
+    QVector<bool> bits;
+    if (ok) {
+        if (req.command == ReadBits) {
+            for (int i = 0; i < req.count; ++i) bits.append(m_memory.at(req.address + i));
+        } else if (req.command == WriteWords) {
+            QStringList text;
+            for (int i = 0; i < req.words.size(); ++i) {
+                m_words[req.address + i] = req.words.at(i);
+                text << QString("%1").arg(req.words.at(i), 4, 16, QChar('0')).toUpper();
+            }
+            emit log(QString("写 D%1 (%2 字): %3").arg(req.address).arg(req.words.size()).arg(text.join(' ')));
+        } else {
+            for (const Point &p : req.points) writeBit(p.address, p.value, true);
+        }
+    }
+    return buildReply(frame, req.command, ok, bits);
+}
+
+QByteArray PlcSimulator::buildReply(Frame frame, int command, bool ok, const QVector<bool> &bits) const
+{
+    QByteArray out;
+    switch (frame) {
+    case Ascii1E:
+        out += QByteArray::number(command | 0x80, 16).toUpper();
+        if (!ok) {
+            out += "5B" + QByteArray::number(kAbnormal1E, 16).toUpper().rightJustified(2, '0');
+            break;
+        }
+        out += "00";
+        for (bool b : bits) out += b ? '1' : '0';
+        if (m_opt.asciiPad && (bits.size() & 1)) out += '0';
+        break;
+    case Binary1E:
+        out += char(command | 0x80);
+        if (!ok) {
+            out += char(0x5B);
+            out += char(kAbnormal1E);
+            break;
+        }
+        out += char(0x00);
+        for (int i = 0; i < bits.size(); i += 2) {
+            quint8 b = quint8(bits.at(i) ? 0x10 : 0x00);
+            if (i + 1 < bits.size() && bits.at(i + 1)) b |= 0x01;
+            out += char(b);
+        }
+        break;
+    case Binary3E: {
+        out += char(0xD0);
+        out += char(0x00);
+        out += char(0x00);                  // 网络号
+        out += char(0xFF);                  // PLC 号
+        putLe(out, 0x03FF, 2);
+        out += char(0x00);
+        int lengthPos = out.size();
+        putLe(out, 0, 2);
+        putLe(out, ok ? 0 : kError3E, 2);
+        if (ok) {
+            for (int i = 0; i < bits.size(); i += 2) {
+                quint8 b = quint8(bits.at(i) ? 0x10 : 0x00);
+                if (i + 1 < bits.size() && bits.at(i + 1)) b |= 0x01;
+                out += char(b);
+            }
+        } else {
+            // 出错信息: 网络号 PLC号 模块IO号 站号 指令 子指令
+            out += char(0x00);
+            out += char(0xFF);
+            putLe(out, 0x03FF, 2);
+            out += char(0x00);
+            putLe(out, quint32(command3E(command)), 2);
+            putLe(out, 0x0001, 2);
+        }
+        int length = out.size() - lengthPos - 2;
+        out[lengthPos] = char(length & 0xFF);
+        out[lengthPos + 1] = char(length >> 8);
+        break;
+    }
+    default:
+        break;
+    }
+    return out;
+}
+
+void PlcSimulator::writeBit(int address, bool value, bool byClient)
+{
+    if (address < 0 || address >= kMemoryBits) return;
+    bool old = m_memory.at(address);
+    m_memory[address] = value;
+    if (old == value) return;
+
+    qint64 now = m_clock.elapsed();
+    if (address == m_opt.startAddress && value) {
+        m_startEdgeMs = now;
+        emit log(QString(">>> M%1 ON (启动)").arg(address));
+    }
+
+    if (byClient && address == m_opt.releaseAddress && value) {
+        // 放行：汇报本轮结果位 (默认地址表的 M1655/M1660/M1665；自定义地址表看写入日志)
+        QString ok, ng;
+        for (int i = 0; i < 5; ++i) {
+            ok += m_memory.at(1655 + i) ? '1' : '0';
+            ng += m_memory.at(1660 + i) ? '1' : '0';
+        }
+        qint64 ms = m_startEdgeMs >= 0 ? now - m_startEdgeMs : -1;
+        if (ms >= 0) m_cycleMs.append(ms);
+        m_startEdgeMs = -1;
+        emit log(QString("<<< M%1 ON (放行) 第 %2 轮，距启动 %3 ms  OK[M1655-]=%4 NG[M1660-]=%5 报警M1665=%6")
+                 .arg(address).arg(m_cycleMs.size()).arg(ms).arg(ok).arg(ng).arg(m_memory.at(1665) ? 1 : 0));
+        emit cycleCompleted(m_cycleMs.size(), ms);
+    }
+}
+
+// -----------------------------------------------------------
+// 应答发送 (按请求顺序；延迟、抖动、半帧、粘包)
+// -----------------------------------------------------------
+void PlcSimulator::queueReply(QTcpSocket *socket, const QByteArray &data)
+{
+    Connection &conn = m_connections[socket];
+    qint64 now = m_clock.elapsed();
+
+    int delay = m_opt.latencyMs;
+    if (m_opt.jitterMs > 0) delay += m_random.bounded(-m_opt.jitterMs, m_opt.jitterMs + 1);
+
+    Pending p;
+    p.dueMs = qMax(now + qMax(0, delay), conn.lastDueMs);
+    p.data = data;
+    p.hold = chance(m_opt.mergeRate);
+    conn.lastDueMs = p.dueMs;
+    conn.pending.enqueue(p);
+
+    scheduleFlush(socket, p.dueMs - now);
+}
+
+void PlcSimulator::scheduleFlush(QTcpSocket *socket, qint64 delayMs)
+{
+    QTimer::singleShot(int(qMax<qint64>(0, delayMs)), socket, [this, socket]() { flush(socket); });
+}
+
+void PlcSimulator::flush(QTcpSocket *socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) return;
+    Connection &conn = it.value();
+    qint64 now = m_clock.elapsed();
+
+    QByteArray out;
+    while (!conn.pending.isEmpty() && conn.pending.head().dueMs <= now) {
+        const Pending &p = conn.pending.head();
+        if (p.hold) {
+            // 粘包：等下一条应答到期一起发，最多等 kMergeHoldMs
+            bool nextDue = conn.pending.size() > 1 && conn.pending.at(1).dueMs <= now;
+            if (!nextDue && now - p.dueMs < kMergeHoldMs) {
+                qint64 wait = conn.pending.size() > 1 ? conn.pending.at(1).dueMs - now
+                                                      : kMergeHoldMs - (now - p.dueMs);
+                scheduleFlush(socket, wait);
+                break;
+            }
+            if (nextDue) m_merges++;
+        }
+        out += p.data;
+        conn.pending.dequeue();
+    }
+    if (out.isEmpty()) return;
+
+    if (out.size() > 1 && chance(m_opt.splitRate)) {
+        // 半帧：先发前一段，剩下的作为队首稍后发出 (后面的应答排在它之后)
+        m_splits++;
+        int cut = 1 + int(m_random.bounded(out.size() - 1));
+        socket->write(out.left(cut));
+        Pending rest;
+        rest.dueMs = now + kSplitGapMs;
+        rest.data = out.mid(cut);
+        conn.pending.prepend(rest);
+        conn.lastDueMs = qMax(conn.lastDueMs, rest.dueMs);
+        scheduleFlush(socket, kSplitGapMs);
+        return;
+    }
+    socket->write(out);
+}
+
+QJsonObject PlcSimulator::summary() const
+{
+    QJsonObject o;
+    o["frame"] = m_opt.frame;
+    o["latencyMs"] = m_opt.latencyMs;
+    o["jitterMs"] = m_opt.jitterMs;
+
+    QVector<qint64> cycles = m_cycleMs;
+    std::sort(cycles.begin(), cycles.end());
+    QJsonObject c;
+    c["count"] = cycles.size();
+    if (!cycles.isEmpty()) {
+        double sum = 0;
+        for (qint64 v : cycles) sum += double(v);
+        c["avgMs"] = sum / cycles.size();
+        c["p50Ms"] = double(cycles.at(cycles.size() / 2));
+        c["maxMs"] = double(cycles.last());
+        c["minMs"] = double(cycles.first());
+    }
+    o["cycles"] = c;
+
+    QJsonObject r;
+    r["read"] = double(m_requests.value(ReadBits));
+    r["write"] = double(m_requests.value(WriteBits));
+    r["randomWrite"] = double(m_requests.value(RandomWriteBits));
+    r["writeWords"] = double(m_requests.value(WriteWords));
+    o["requests"] = r;
+
+    QJsonObject f;
+    f["disconnects"] = double(m_disconnects);
+    f["silent"] = double(m_silent);
+    f["errors"] = double(m_errors);
+    f["splits"] = double(m_splits);
+    f["merges"] = double(m_merges);
+    f["badFrames"] = double(m_badFrames);
+    o["faults"] = f;
+    return o;
+}
@@ -0,0 +1,146 @@
+#ifndef PLCSIMULATOR_H
+#define PLCSIMULATOR_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QQueue>
+#include <QVector>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QJsonObject>
+#include <QTimer>
+
+// 模拟器参数 (命令行设置)
+struct SimOptions {
+    quint16 port = 3050;
+    QString frame = "auto";         // auto / ascii1e / binary1e / binary3e
+    int latencyMs = 5;              // 应答延迟
+    int jitterMs = 0;               // 延迟抖动 (在 latency 上随机加减)
+    double disconnectRate = 0.0;    // 收到请求时直接断开连接的概率
+    double silentRate = 0.0;        // 收到请求不应答的概率 (测试超时)
+    double errorRate = 0.0;         // 以异常结束代码应答的概率
+    double splitRate = 0.0;         // 把应答拆成两段、间隔发出的概率
+    double mergeRate = 0.0;         // 扣住应答、与下一条合并发出的概率
+    bool asciiPad = false;          // ASCII 奇数点读应答补一个 '0'
+    int startAddress = 1600;        // 启动信号 (内置脚本与周期统计用)
+    int releaseAddress = 1650;      // 放行信号
+    quint32 seed = 1;
+};
+
+/**
+ * @brief 三菱 MC 协议 PLC 模拟器 (M 继电器)
+ * * QTcpServer 监听，支持 A 兼容 1E 帧 (ASCII / 二进制) 与 QnA 兼容 3E 帧 (二进制)，
+ *   指令只实现本程序用到的位读、位成批写、位随机写，以及 D 寄存器字成批写。
+ * * 帧格式可固定，也可按连接上第一帧自动识别。
+ * * 应答按请求顺序发出，可设置延迟/抖动，并按概率注入故障：断线、不应答、
+ *   异常应答、半帧 (拆成两段发出)、粘包 (两条应答合并发出)。
+ * * 脚本驱动启动沿 (默认 M1600)：见 main.cpp 的脚本说明。客户端写放行位 (默认 M1650) =1 视为一轮结束，
+ *   统计启动沿到放行的时间。
+ */
+class PlcSimulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlcSimulator(const SimOptions &opt, QObject *parent = nullptr);
+
+    bool start();
+    // 脚本每行一条指令；语法错误时返回 false 并给出行号
+    bool setScript(const QStringList &lines, QString *error);
+
+    bool bit(int address) const;
+    QJsonObject summary() const;
+
+signals:
+    void log(const QString &msg);
+    void scriptFinished();
+    // 客户端写放行位=1：第 n 轮，距启动沿 ms
+    void cycleCompleted(int n, qint64 ms);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+    void runScript();
+
+private:
+    enum Frame { Unknown, Ascii1E, Binary1E, Binary3E };
+    enum Command { ReadBits = 0x00, WriteBits = 0x02, WriteWords = 0x03, RandomWriteBits = 0x04 };
+
+    struct Point {
+        int address;
+        bool value;
+    };
+
+    struct Request {
+        int command = -1;
+        int address = 0;        // 成批读写的起始地址
+        int count = 0;
+        QVector<Point> points;  // 写入的各点
+        QVector<quint16> words; // WriteWords：从 address 起的各字 (D)
+        bool supported = true;  // 设备代码/子指令不支持，或地址越界：以异常应答
+    };
+
+    struct Pending {
+        qint64 dueMs = 0;
+        QByteArray data;
+        bool hold = false;      // 等下一条应答一起发 (粘包)
+    };
+
+    struct Connection {
+        Frame frame = Unknown;
+        QByteArray rx;
+        QQueue<Pending> pending;
+        qint64 lastDueMs = 0;   // 保证应答按顺序
+    };
+
+    struct Step {
+        enum Op { Delay, Set, Wait, Log, Loop, End };
+        Op op = End;
+        int address = 0;
+        bool value = false;
+        int ms = 0;
+        QString text;
+    };
+
+    Frame detectFrame(const QByteArray &rx) const;
+    int parseRequest(Frame frame, const QByteArray &rx, Request *req) const;
+    int parseAscii1E(const QByteArray &rx, Request *req) const;
+    int parseBinary1E(const QByteArray &rx, Request *req) const;
+    int parseBinary3E(const QByteArray &rx, Request *req) const;
+    QByteArray execute(Frame frame, const Request &req);
+    QByteArray buildReply(Frame frame, int command, bool ok, const QVector<bool> &bits) const;
+
+    void queueReply(QTcpSocket *socket, const QByteArray &data);
+    void flush(QTcpSocket *socket);
+    void scheduleFlush(QTcpSocket *socket, qint64 delayMs);
+    void writeBit(int address, bool value, bool byClient);
+    bool chance(double p);
+
+private:
+    SimOptions m_opt;
+    QTcpServer *m_server;
+    QHash<QTcpSocket *, Connection> m_connections;
+    QVector<bool> m_memory;         // M0 ~ M8191
+    QVector<quint16> m_words;       // D0 ~ D8191
+    QRandomGenerator m_random;
+    QElapsedTimer m_clock;
+
+    // 脚本
+    QVector<Step> m_script;
+    int m_pc = 0;
+    QTimer *m_scriptTimer;
+    qint64 m_waitDeadlineMs = -1;
+
+    // 统计
+    qint64 m_startEdgeMs = -1;
+    QVector<qint64> m_cycleMs;      // 每轮 启动沿 -> 放行 (M1650=1)
+    QHash<int, qint64> m_requests;  // 按指令计数
+    qint64 m_disconnects = 0, m_silent = 0, m_errors = 0, m_splits = 0, m_merges = 0;
+    qint64 m_badFrames = 0;
+};
+
+#endif // PLCSIMULATOR_H
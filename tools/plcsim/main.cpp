@@ -0,0 +1,151 @@
+/**
+ * 三菱 MC 协议 PLC 模拟器
+ *
+ * 在本机起一个 TCP 服务端代替现场 PLC，主程序把 plc_automation 的 ip 指向 127.0.0.1、
+ * port 指向这里即可，不用上产线就能跑通 启动 -> 测试 -> 写结果 -> 放行 的整轮流程，
+ * 并统计每轮耗时 (M1600 上升沿到主程序写 M1650=1)。
+ *
+ *   plcsim [--port 3050] [--frame auto|ascii1e|binary1e|binary3e]
+ *          [--latency 5] [--jitter 0] [--disconnect-rate 0] [--silent-rate 0]
+ *          [--error-rate 0] [--split-rate 0] [--merge-rate 0] [--ascii-pad]
+ *          [--seed 1] [--script file] [--idle-ms 2000] [--cycles N]
+ *          [--duration 秒] [--json plcsim.json] [--start 1600] [--release 1650]
+ *
+ * 故障概率都按每条请求/应答计，取值 0~1。
+ *
+ * 脚本每行一条指令，# 之后为注释：
+ *   delay <ms>              等待
+ *   set M<地址> <0|1>       置位/复位
+ *   wait M<地址> <0|1> [ms] 等到该位为指定值 (超时只记日志，继续往下)
+ *   log <文本>              打印
+ *   loop                    回到第一行
+ *   end                     结束脚本
+ *
+ * 不给 --script 时用内置脚本：空闲 idle-ms 后给启动位 (M1600) 上升沿，等主程序写放行位
+ * (M1650) =1，撤掉启动位、复位放行位，循环。主程序配置了 address_map 时用 --start/--release
+ * 指定相同的地址。
+ */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QTimer>
+#include <cstdio>
+
+#include "PlcSimulator.h"
+
+namespace {
+QStringList defaultScript(int idleMs, int start, int release)
+{
+    return QStringList()
+        << QString("delay %1").arg(idleMs)
+        << QString("set M%1 1").arg(start)
+        << QString("wait M%1 1 60000").arg(release)
+        << QString("set M%1 0").arg(start)
+        << "delay 300"
+        << QString("set M%1 0").arg(release)
+        << "loop";
+}
+
+void printLine(const QString &msg)
+{
+    fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+    fflush(stderr);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("plcsim");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("三菱 MC 协议 PLC 模拟器 (M 继电器)");
+    parser.addHelpOption();
+    QCommandLineOption portOpt("port", "监听端口", "port", "3050");
+    QCommandLineOption frameOpt("frame", "帧格式 auto/ascii1e/binary1e/binary3e", "frame", "auto");
+    QCommandLineOption latencyOpt("latency", "应答延迟 (ms)", "ms", "5");
+    QCommandLineOption jitterOpt("jitter", "延迟抖动 (ms)", "ms", "0");
+    QCommandLineOption disconnectOpt("disconnect-rate", "断线概率", "p", "0");
+    QCommandLineOption silentOpt("silent-rate", "不应答概率", "p", "0");
+    QCommandLineOption errorOpt("error-rate", "异常应答概率", "p", "0");
+    QCommandLineOption splitOpt("split-rate", "半帧概率", "p", "0");
+    QCommandLineOption mergeOpt("merge-rate", "粘包概率", "p", "0");
+    QCommandLineOption padOpt("ascii-pad", "ASCII 奇数点读应答补 '0'");
+    QCommandLineOption seedOpt("seed", "随机种子", "n", "1");
+    QCommandLineOption scriptOpt("script", "脚本文件", "file");
+    QCommandLineOption idleOpt("idle-ms", "内置脚本两轮之间的空闲时间 (ms)", "ms", "2000");
+    QCommandLineOption cyclesOpt("cycles", "完成 N 轮后退出", "n", "0");
+    QCommandLineOption durationOpt("duration", "运行多少秒后退出", "s", "0");
+    QCommandLineOption jsonOpt("json", "退出时把统计写到 JSON 文件", "file");
+    QCommandLineOption startOpt("start", "启动信号 M 地址", "address", "1600");
+    QCommandLineOption releaseOpt("release", "放行信号 M 地址", "address", "1650");
+    parser.addOptions({ portOpt, frameOpt, latencyOpt, jitterOpt, disconnectOpt, silentOpt, errorOpt,
+                        splitOpt, mergeOpt, padOpt, seedOpt, scriptOpt, idleOpt, cyclesOpt,
+                        durationOpt, jsonOpt, startOpt, releaseOpt });
+    parser.process(app);
+
+    SimOptions opt;
+    opt.port = quint16(parser.value(portOpt).toUInt());
+    opt.frame = parser.value(frameOpt).toLower();
+    opt.latencyMs = qMax(0, parser.value(latencyOpt).toInt());
+    opt.jitterMs = qMax(0, parser.value(jitterOpt).toInt());
+    opt.disconnectRate = parser.value(disconnectOpt).toDouble();
+    opt.silentRate = parser.value(silentOpt).toDouble();
+    opt.errorRate = parser.value(errorOpt).toDouble();
+    opt.splitRate = parser.value(splitOpt).toDouble();
+    opt.mergeRate = parser.value(mergeOpt).toDouble();
+    opt.asciiPad = parser.isSet(padOpt);
+    opt.seed = parser.value(seedOpt).toUInt();
+    opt.startAddress = parser.value(startOpt).toInt();
+    opt.releaseAddress = parser.value(releaseOpt).toInt();
+
+    if (!QStringList({ "auto", "ascii1e", "binary1e", "binary3e" }).contains(opt.frame)) {
+        printLine(QString("未知帧格式: %1").arg(opt.frame));
+        return 1;
+    }
+
+    QStringList script;
+    if (parser.isSet(scriptOpt)) {
+        QFile f(parser.value(scriptOpt));
+        if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            printLine(QString("无法打开脚本: %1").arg(f.fileName()));
+            return 1;
+        }
+        QTextStream in(&f);
+        while (!in.atEnd()) script << in.readLine();
+    } else {
+        script = defaultScript(qMax(0, parser.value(idleOpt).toInt()), opt.startAddress, opt.releaseAddress);
+    }
+
+    PlcSimulator sim(opt);
+    QObject::connect(&sim, &PlcSimulator::log, &printLine);
+
+    QString error;
+    if (!sim.setScript(script, &error)) {
+        printLine(error);
+        return 1;
+    }
+
+    int cycles = parser.value(cyclesOpt).toInt();
+    if (cycles > 0) {
+        QObject::connect(&sim, &PlcSimulator::cycleCompleted, &app, [&app, cycles](int n, qint64) {
+            if (n >= cycles) app.quit();
+        });
+    }
+    int duration = parser.value(durationOpt).toInt();
+    if (duration > 0) QTimer::singleShot(duration * 1000, &app, &QCoreApplication::quit);
+
+    if (!sim.start()) return 1;
+    int ret = app.exec();
+
+    QByteArray json = QJsonDocument(sim.summary()).toJson(QJsonDocument::Indented);
+    fprintf(stdout, "%s", json.constData());
+    if (parser.isSet(jsonOpt)) {
+        QFile out(parser.value(jsonOpt));
+        if (out.open(QIODevice::WriteOnly | QIODevice::Truncate)) out.write(json);
+        else printLine(QString("无法写入 %1").arg(out.fileName()));
+    }
+    return ret;
+}
@@ -0,0 +1,20 @@
+# 三菱 MC 协议 PLC 模拟器 (独立控制台程序，不进主程序)
+# 用法见 main.cpp 开头的说明
+QT       += core network
+QT       -= gui
+
+TARGET = plcsim
+TEMPLATE = app
+
+CONFIG += c++11 release console
+CONFIG -= app_bundle
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    PlcSimulator.cpp \
+    main.cpp
+
+HEADERS += \
+    PlcSimulator.h
+
+DEFINES += __stddef_h_builtins
@@ -0,0 +1,384 @@
+/**
+ * SnManager 性能基准
+ *
+ * 生成合成的 IMSI,SN 数据表 (默认 1K / 100K / 1M / 10M 行)，对每个规模测：
+ *   - 冷加载：删掉 .idx，解析 CSV + 构建 + 写索引文件
+ *   - 热加载：索引文件已存在，直接映射
+ *   - 加载后的常驻内存与进程峰值内存
+ *   - 1 / 4 / 16 个线程并发 checkIdentity 的命中、未命中延迟与吞吐
+ * 结果写成 JSON 和 CSV，改动存储结构前后各跑一次即可对比。
+ *
+ * 每个规模在单独的子进程里跑 (本程序带 --dataset 自调用)，峰值内存互不干扰。
+ *
+ *   snbench [--rows 1000,100000,1000000,10000000] [--readers 1,4,16]
+ *           [--lookups 200000] [--dir snbench_data] [--json snbench.json]
+ *           [--csv snbench.csv] [--keep]
+ */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QProcess>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QSemaphore>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+
+#include "SnManager.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const quint64 kScramble = 2654435761ull;        // 与 10^12 互素，序号 -> IMSI 是一一映射
+const quint64 kImsiSpace = 1000000000000ull;    // IMSI 后 12 位
+const int kKeyPool = 65536;                     // 每个线程轮流查询的键数
+const int kBatch = 64;                          // 每批查询计一次时，摊薄计时本身的开销
+
+// 第 i 行的 IMSI；未命中用例换一个 MCC 前缀，保证表中没有
+QString imsiFor(quint64 i, bool miss)
+{
+    return QString("%1%2").arg(miss ? "461" : "460").arg((i * kScramble) % kImsiSpace, 12, 10, QChar('0'));
+}
+
+// 当前常驻内存 / 峰值常驻内存 (KB)
+void memoryKb(qint64 *rssKb, qint64 *peakKb)
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        *rssKb = qint64(pmc.WorkingSetSize / 1024);
+        *peakKb = qint64(pmc.PeakWorkingSetSize / 1024);
+        return;
+    }
+    *rssKb = *peakKb = -1;
+#else
+    *rssKb = -1;
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> f = statm.readAll().split(' ');
+        if (f.size() > 1) *rssKb = f.at(1).toLongLong() * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+    struct rusage ru;
+    *peakKb = getrusage(RUSAGE_SELF, &ru) == 0 ? qint64(ru.ru_maxrss) : -1;
+#endif
+}
+
+// 生成数据表；同样行数的文件已存在就直接用
+bool generate(const QString &path, qint64 rows)
+{
+    QFileInfo info(path);
+    if (info.exists() && info.size() > 0) return true;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QByteArray buf;
+    buf.reserve(1 << 20);
+    for (qint64 i = 0; i < rows; ++i) {
+        buf += imsiFor(quint64(i), false).toLatin1();
+        buf += ",SN";
+        buf += QByteArray::number(i).rightJustified(10, '0');
+        buf += '\n';
+        if (buf.size() >= (1 << 20) - 64) {
+            if (file.write(buf) != buf.size()) return false;
+            buf.clear();
+        }
+    }
+    return file.write(buf) == buf.size();
+}
+
+struct ReaderResult {
+    QVector<qint64> batchNs;    // 每批 kBatch 次查询的耗时
+    qint64 found = 0;
+};
+
+// n 个线程同时开始，各查 lookups 次；返回总墙钟时间 (ns)
+qint64 runReaders(SnManager *sn, const QVector<QString> &keys, int n, int lookups, QVector<ReaderResult> *results)
+{
+    results->clear();
+    results->resize(n);
+    QSemaphore ready, go;
+    QVector<QThread *> threads;
+
+    for (int t = 0; t < n; ++t) {
+        ReaderResult *res = &(*results)[t];
+        threads.append(QThread::create([=, &keys, &ready, &go]() {
+            res->batchNs.reserve(lookups / kBatch + 1);
+            QString out;
+            int k = (t * 7919) % keys.size();   // 各线程从不同位置开始
+            ready.release();
+            go.acquire();
+
+            QElapsedTimer timer;
+            for (int done = 0; done < lookups; done += kBatch) {
+                timer.start();
+                for (int i = 0; i < kBatch; ++i) {
+                    if (sn->checkIdentity(keys.at(k), out)) res->found++;
+                    if (++k == keys.size()) k = 0;
+                }
+                res->batchNs.append(timer.nsecsElapsed());
+            }
+        }));
+        threads.last()->start();
+    }
+
+    ready.acquire(n);
+    QElapsedTimer wall;
+    wall.start();
+    go.release(n);
+    for (QThread *th : threads) {
+        th->wait();
+        delete th;
+    }
+    return wall.nsecsElapsed();
+}
+
+QJsonObject latency(const QVector<ReaderResult> &results, qint64 wallNs, int readers, int lookups)
+{
+    QVector<double> perOp;
+    qint64 found = 0;
+    double sum = 0;
+    for (const ReaderResult &r : results) {
+        for (qint64 ns : r.batchNs) {
+            perOp.append(double(ns) / kBatch);
+            sum += double(ns);
+        }
+        found += r.found;
+    }
+    std::sort(perOp.begin(), perOp.end());
+
+    auto pct = [&](double p) {
+        return perOp.isEmpty() ? 0.0 : perOp.at(qMin(perOp.size() - 1, int(p * perOp.size())));
+    };
+    qint64 total = qint64(perOp.size()) * kBatch;
+
+    QJsonObject o;
+    o["readers"] = readers;
+    o["lookupsPerReader"] = lookups;
+    o["found"] = double(found);
+    o["meanNs"] = total ? sum / double(total) : 0.0;
+    o["p50Ns"] = pct(0.50);
+    o["p99Ns"] = pct(0.99);
+    o["maxNs"] = perOp.isEmpty() ? 0.0 : perOp.last();
+    o["mopsPerSec"] = wallNs > 0 ? double(total) * 1000.0 / double(wallNs) : 0.0;
+    return o;
+}
+
+// 子进程：跑一个规模，结果以一行 JSON 打到 stdout
+int runDataset(qint64 rows, const QList<int> &readers, int lookups, const QString &dir, bool keep)
+{
+    QDir().mkpath(dir);
+    QString csvPath = QDir(dir).filePath(QString("sn_%1.csv").arg(rows));
+    QString idxPath = csvPath + ".idx";
+
+    QJsonObject o;
+    o["rows"] = double(rows);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!generate(csvPath, rows)) {
+        fprintf(stderr, "snbench: 无法生成 %s\n", qPrintable(csvPath));
+        return 1;
+    }
+    o["generateMs"] = double(timer.elapsed());
+    o["csvBytes"] = double(QFileInfo(csvPath).size());
+
+    // 1. 冷加载：解析 + 构建 + 写索引
+    QFile::remove(idxPath);
+    {
+        SnManager cold;
+        timer.start();
+        if (!cold.loadData(csvPath)) {
+            fprintf(stderr, "snbench: 加载失败 %s\n", qPrintable(csvPath));
+            return 1;
+        }
+        o["coldLoadMs"] = double(timer.elapsed());
+        o["count"] = cold.getDataCount();
+    }
+    o["indexBytes"] = double(QFileInfo(idxPath).size());
+
+    // 2. 热加载：映射已有索引，之后的查表都在这份上跑
+    qint64 rssBefore = 0, peak = 0;
+    memoryKb(&rssBefore, &peak);
+
+    SnManager sn;
+    timer.start();
+    sn.loadData(csvPath);
+    o["warmLoadMs"] = double(timer.elapsed());
+
+    // 3. 查询键：命中键均匀取自全表，未命中键不在表中
+    QVector<QString> hitKeys, missKeys;
+    int pool = int(qMin<qint64>(kKeyPool, rows));
+    hitKeys.reserve(pool);
+    missKeys.reserve(kKeyPool);
+    for (int i = 0; i < pool; ++i) hitKeys.append(imsiFor(quint64((qint64(i) * 48271) % rows), false));
+    for (int i = 0; i < kKeyPool; ++i) missKeys.append(imsiFor(quint64(i) * 7 + 1, true));
+
+    QJsonArray hits, misses;
+    for (int n : readers) {
+        QVector<ReaderResult> res;
+        qint64 wall = runReaders(&sn, hitKeys, n, lookups, &res);
+        hits.append(latency(res, wall, n, lookups));
+        wall = runReaders(&sn, missKeys, n, lookups, &res);
+        misses.append(latency(res, wall, n, lookups));
+    }
+    o["hit"] = hits;
+    o["miss"] = misses;
+
+    SnLookupStats st = sn.getLookupStats();
+    o["filterRejects"] = double(st.filterRejects);
+    o["falsePositives"] = double(st.falsePositives);
+    o["falsePositiveRate"] = st.falsePositiveRate;
+
+    qint64 rss = 0;
+    memoryKb(&rss, &peak);
+    o["rssDeltaKb"] = double(rss - rssBefore);  // 热加载 + 查询键占用
+    o["peakRssKb"] = double(peak);              // 含冷加载构建期间
+
+    if (!keep) {
+        sn.clearData();
+        QFile::remove(idxPath);
+        QFile::remove(csvPath);
+    }
+
+    fprintf(stdout, "%s\n", QJsonDocument(o).toJson(QJsonDocument::Compact).constData());
+    return 0;
+}
+
+QList<int> parseList(const QString &text)
+{
+    QList<int> list;
+    for (const QString &s : text.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        int v = s.trimmed().toInt(&ok);
+        if (ok && v > 0) list.append(v);
+    }
+    return list;
+}
+
+// 查表源码里的 qDebug 会淹没结果，只留警告
+void quietHandler(QtMsgType type, const QMessageLogContext &, const QString &msg)
+{
+    if (type == QtDebugMsg || type == QtInfoMsg) return;
+    fprintf(stderr, "%s\n", qPrintable(msg));
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("SnManager 加载与查表性能基准");
+    parser.addHelpOption();
+    QCommandLineOption rowsOpt("rows", "数据表行数，逗号分隔", "list", "1000,100000,1000000,10000000");
+    QCommandLineOption readersOpt("readers", "并发查表线程数，逗号分隔", "list", "1,4,16");
+    QCommandLineOption lookupsOpt("lookups", "每个线程的查询次数", "n", "200000");
+    QCommandLineOption dirOpt("dir", "数据表存放目录", "path", "snbench_data");
+    QCommandLineOption jsonOpt("json", "JSON 结果文件", "path", "snbench.json");
+    QCommandLineOption csvOpt("csv", "CSV 结果文件", "path", "snbench.csv");
+    QCommandLineOption keepOpt("keep", "保留生成的数据表和索引 (下次直接复用)");
+    QCommandLineOption verboseOpt("verbose", "显示 SnManager 的调试输出");
+    QCommandLineOption datasetOpt("dataset", "(内部) 在本进程里只跑一个规模", "rows");
+    parser.addOptions({ rowsOpt, readersOpt, lookupsOpt, dirOpt, jsonOpt, csvOpt, keepOpt, verboseOpt, datasetOpt });
+    parser.process(app);
+
+    if (!parser.isSet(verboseOpt)) qInstallMessageHandler(quietHandler);
+
+    QList<int> readers = parseList(parser.value(readersOpt));
+    int lookups = qMax(kBatch, parser.value(lookupsOpt).toInt());
+
+    if (parser.isSet(datasetOpt)) {
+        return runDataset(parser.value(datasetOpt).toLongLong(), readers, lookups,
+                          parser.value(dirOpt), parser.isSet(keepOpt));
+    }
+
+    // 主进程：每个规模起一个子进程，汇总结果
+    QJsonArray results;
+    for (int rows : parseList(parser.value(rowsOpt))) {
+        QStringList args;
+        args << "--dataset" << QString::number(rows)
+             << "--readers" << parser.value(readersOpt)
+             << "--lookups" << QString::number(lookups)
+             << "--dir" << parser.value(dirOpt);
+        if (parser.isSet(keepOpt)) args << "--keep";
+        if (parser.isSet(verboseOpt)) args << "--verbose";
+
+        fprintf(stderr, "snbench: %d 行 ...\n", rows);
+        QProcess child;
+        child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        child.start(QCoreApplication::applicationFilePath(), args);
+        if (!child.waitForFinished(-1) || child.exitCode() != 0) {
+            fprintf(stderr, "snbench: %d 行的测试失败\n", rows);
+            return 1;
+        }
+
+        QJsonObject o = QJsonDocument::fromJson(child.readAllStandardOutput().trimmed()).object();
+        results.append(o);
+        fprintf(stderr, "    冷加载 %.0f ms，热加载 %.0f ms，峰值内存 %.0f KB\n",
+                o["coldLoadMs"].toDouble(), o["warmLoadMs"].toDouble(), o["peakRssKb"].toDouble());
+    }
+
+    QJsonObject meta;
+    meta["time"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    meta["host"] = QSysInfo::machineHostName();
+    meta["os"] = QSysInfo::prettyProductName();
+    meta["cpu"] = QSysInfo::currentCpuArchitecture();
+    meta["threads"] = QThread::idealThreadCount();
+    meta["qt"] = QString(qVersion());
+    meta["batch"] = kBatch;
+
+    QJsonObject root;
+    root["meta"] = meta;
+    root["results"] = results;
+
+    QFile json(parser.value(jsonOpt));
+    if (!json.open(QIODevice::WriteOnly)) {
+        fprintf(stderr, "snbench: 无法写入 %s\n", qPrintable(json.fileName()));
+        return 1;
+    }
+    json.write(QJsonDocument(root).toJson());
+    json.close();
+
+    // CSV：每个 (规模, 命中/未命中, 线程数) 一行，便于直接在表格里对比
+    QFile csv(parser.value(csvOpt));
+    if (!csv.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        fprintf(stderr, "snbench: 无法写入 %s\n", qPrintable(csv.fileName()));
+        return 1;
+    }
+    QTextStream ts(&csv);
+    ts << "rows,csv_bytes,index_bytes,cold_load_ms,warm_load_ms,peak_rss_kb,rss_delta_kb,"
+          "kind,readers,mean_ns,p50_ns,p99_ns,max_ns,mops_per_sec\n";
+    for (const QJsonValue &v : results) {
+        QJsonObject o = v.toObject();
+        for (const char *kind : { "hit", "miss" }) {
+            for (const QJsonValue &lv : o[kind].toArray()) {
+                QJsonObject l = lv.toObject();
+                ts << qint64(o["rows"].toDouble()) << ',' << qint64(o["csvBytes"].toDouble()) << ','
+                   << qint64(o["indexBytes"].toDouble()) << ',' << o["coldLoadMs"].toDouble() << ','
+                   << o["warmLoadMs"].toDouble() << ',' << qint64(o["peakRssKb"].toDouble()) << ','
+                   << qint64(o["rssDeltaKb"].toDouble()) << ',' << kind << ',' << l["readers"].toInt() << ','
+                   << l["meanNs"].toDouble() << ',' << l["p50Ns"].toDouble() << ',' << l["p99Ns"].toDouble() << ','
+                   << l["maxNs"].toDouble() << ',' << l["mopsPerSec"].toDouble() << '\n';
+            }
+        }
+    }
+
+    fprintf(stderr, "snbench: 结果已写入 %s / %s\n", qPrintable(json.fileName()), qPrintable(csv.fileName()));
+    return 0;
+}
@@ -0,0 +1,28 @@
+# SnManager 性能基准 (独立控制台程序，不进主程序)
+# 用法见 main.cpp 开头的说明
+QT       += core concurrent
+QT       -= gui
+
+TARGET = snbench
+TEMPLATE = app
+
+CONFIG += c++11 release console
+CONFIG -= app_bundle
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 直接编译主程序的 SN 查表源码，测的就是现场跑的代码
+SOURCES += \
+    ../../SnIndex.cpp \
+    ../../SnManager.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../SnIndex.h \
+    ../../SnManager.h
+
+INCLUDEPATH += $$PWD/../..
+
+# 峰值内存 (GetProcessMemoryInfo)
+win32: LIBS += -lpsapi
+
+DEFINES += __stddef_h_builtins